@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/workqueue.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -72,6 +73,7 @@ struct channel {
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	struct work unexpected_work;        /* Reports a spurious interrupt. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -95,6 +97,7 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static work_func report_unexpected;
 
 /* Initialize the disk subsystem and detect disks. */
 void
@@ -122,6 +125,7 @@ disk_init (void) {
 		lock_init (&c->lock);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		work_init (&c->unexpected_work, report_unexpected, c, WORK_LOW);
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -522,13 +526,21 @@ interrupt_handler (struct intr_frame *f) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
 				sema_up (&c->completion_wait);      /* Wake up waiter. */
 			} else
-				printf ("%s: unexpected interrupt\n", c->name);
+				queue_work (&c->unexpected_work);   /* Print it later. */
 			return;
 		}
 
 	NOT_REACHED ();
 }
 
+/* Reports a spurious interrupt on channel C_, from a worker
+   thread rather than the interrupt handler. */
+static void
+report_unexpected (void *c_) {
+	struct channel *c = c_;
+	printf ("%s: unexpected interrupt\n", c->name);
+}
+
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
@@ -3,10 +3,14 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/apic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
+#include "threads/softirq.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 //원하는 빈도로 타이머 설정하기
@@ -16,65 +20,121 @@
 #if TIMER_FREQ < 19
 #error 8254 timer requires TIMER_FREQ >= 19
 #endif
-#if TIMER_FREQ > 1000
-#error TIMER_FREQ <= 1000 recommended
+#if TIMER_FREQ > 10000
+#error TIMER_FREQ <= 10000 recommended
 #endif
 
+/* 8254 input frequency, and the count that divides it down to
+   TIMER_FREQ, rounded to nearest. */
+#define PIT_HZ 1193180
+#define PIT_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+#define NS_PER_SEC 1000000000ULL
+#define NS_PER_TICK (NS_PER_SEC / TIMER_FREQ)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
-/* Number of loops per timer tick.
-   Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
+/* -tickless: stop the periodic tick while the CPU is idle? */
+bool timer_tickless;
 
-static intr_handler_func timer_interrupt;
-static bool too_many_loops (unsigned loops);
-static void busy_wait (int64_t loops);
-static void real_time_sleep (int64_t num, int32_t denom);
+/* State of the tick timer, when it is not simply interrupting
+   every tick. */
+static enum {
+	TICK_PERIODIC,              /* Interrupting every tick. */
+	TICK_STOPPED,               /* One-shot for the next deadline. */
+	TICK_RESYNC,                /* One-shot for the rest of a tick. */
+	TICK_HRTIMER                /* One-shot for a sub-tick sleeper. */
+} tick_state;
+static unsigned stopped_count;  /* Counts programmed when stopped. */
+static unsigned stopped_phase;  /* Counts left in the tick at stop. */
 
-/* Sets up the 8254 Programmable Interval Timer (PIT) to
-   interrupt PIT_FREQ times per second, and registers the
-   corresponding interrupt. */
-void
-timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
+/* With -apic, the local APIC timer drives the tick instead.  It
+   is armed for one tick at a time, or for the next timer
+   deadline while idle in tickless mode. */
+static uint64_t lapic_hz;           /* Timer clocks per second. */
+static uint64_t lapic_tick_counts;  /* Timer clocks per tick. */
+static uint64_t lapic_armed;        /* Clocks programmed at last arm. */
+static uint64_t lapic_phase;        /* Clocks left in the tick at stop. */
 
-	   //인터럽트 되는 코드. 하드웨어 적인 코드. 그래서 어셈블리어로 되어있나 ?
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+/* The TSC is the clocksource behind timer_ns().  Cycles since
+   tsc_base convert to nanoseconds as cycles * tsc_mult / 2**32.
+   Initialized by tsc_calibrate(). */
+static uint64_t tsc_base;
+static uint64_t tsc_mult;
+static uint64_t tsc_hz;
 
-// 0x43 = 타이머 깨우기.
-// PIT (가상의 타이머) 를 초기화하는것.
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */ 
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+/* Threads sleeping for less than a tick, in order of wake time.
+   The tick timer is switched to one-shot mode (TICK_HRTIMER) to
+   interrupt at the first wake time, then for whatever is left of
+   the tick (TICK_RESYNC) before it goes back to periodic mode. */
+struct hr_sleeper {
+	struct list_elem elem;      /* Element in hr_sleepers. */
+	uint64_t wake_ns;           /* timer_ns() at which to wake. */
+	struct thread *thread;      /* Sleeping thread. */
+};
+static struct list hr_sleepers;
+static uint64_t hr_phase;       /* Clocks from the one-shot to the tick. */
 
-	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
-}
+/* Sleeps shorter than this spin on the TSC instead, since they
+   would not outlast a context switch and an interrupt. */
+#define HR_SLEEP_MIN_NS 10000
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
-void
-timer_calibrate (void) {
-	unsigned high_bit, test_bit;
+/* Hierarchical timer wheel holding the pending timer_events.
+   Level 0 has one slot per tick for the next WHEEL_SIZE ticks.
+   Each slot of level N covers WHEEL_SIZE**N ticks; when level 0
+   wraps around, the matching slot of the next level up is
+   "cascaded", i.e. its timers are redistributed into the lower
+   levels.  Insertion and cancellation are O(1), and each timer
+   is cascaded at most WHEEL_LEVELS - 1 times before it fires. */
+#define WHEEL_BITS 8
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
 
-	ASSERT (intr_get_level () == INTR_ON);
-	printf ("Calibrating timer...  ");
+/* Next tick that the wheel has not yet processed. */
+static int64_t wheel_clock;
 
-	/* Approximate loops_per_tick as the largest power-of-two
-	   still less than one timer tick. */
-	loops_per_tick = 1u << 10;
-	while (!too_many_loops (loops_per_tick << 1)) {
-		loops_per_tick <<= 1;
-		ASSERT (loops_per_tick != 0);
-	}
+static intr_handler_func timer_interrupt;
+static void pit_program (int mode, uint16_t count);
+static uint16_t pit_read (bool *expired);
+static void pit_delay (uint16_t count);
+static void lapic_tick_init (void);
+static void lapic_arm (uint64_t counts);
+static void lapic_idle_enter (void);
+static void lapic_irq_enter (void);
+static void tsc_calibrate (void);
+static void hr_sleep (uint64_t ns);
+static void hr_wake (void);
+static void hr_program (void);
+static void hr_interrupt (void);
+static void wheel_insert (struct timer_event *);
+static void wheel_run (int64_t now);
+static softirq_func timer_softirq;
+static void real_time_sleep (int64_t num, int32_t denom);
 
-	/* Refine the next 8 bits of loops_per_tick. */
-	high_bit = loops_per_tick;
-	for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-		if (!too_many_loops (high_bit | test_bit))
-			loops_per_tick |= test_bit;
+/* Sets up the 8254 Programmable Interval Timer (PIT), or with
+   -apic the local APIC timer, to interrupt TIMER_FREQ times per
+   second, and registers the corresponding interrupt. */
+void
+timer_init (void) {
+	//인터럽트 되는 코드. 하드웨어 적인 코드. 그래서 어셈블리어로 되어있나 ?
+// PIT (가상의 타이머) 를 초기화하는것.
+	for (int level = 0; level < WHEEL_LEVELS; level++)
+		for (int slot = 0; slot < WHEEL_SIZE; slot++)
+			list_init (&wheel[level][slot]);
+	list_init (&hr_sleepers);
+	softirq_register (SOFTIRQ_TIMER, timer_softirq, "timer");
 
-	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+	tsc_calibrate ();
+	if (apic_enabled) {
+		lapic_tick_init ();
+		intr_register_ext (0x20, timer_interrupt, "LAPIC Timer");
+	} else {
+		pit_program (2, PIT_COUNT);
+		intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+	}
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -94,6 +154,24 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then; // 현재의 틱스 - start(인자로 들어오는것)
 }
 
+/* Returns the TSC's rate, in cycles per second. */
+uint64_t
+timer_tsc_hz (void) {
+	return tsc_hz;
+}
+
+/* Returns the number of nanoseconds since timer_init(), read
+   from the TSC.  Monotonic, and much finer than a tick.  Safe to
+   call with interrupts off or from an interrupt handler. */
+uint64_t
+timer_ns (void) {
+	uint64_t cycles = rdtsc () - tsc_base;
+
+	/* cycles * tsc_mult >> 32, without a 128-bit product. */
+	return (cycles >> 32) * tsc_mult
+		+ (((cycles & 0xffffffff) * tsc_mult) >> 32);
+}
+
 //스레드를 틱 타이머 동안 실행을 일시 중단
 /* Suspends execution for approximately TICKS timer ticks. */
 void
@@ -143,6 +221,149 @@ timer_nsleep (int64_t ns) {
 	real_time_sleep (ns, 1000 * 1000 * 1000);
 }
 
+/* Arranges for FUNC (AUX) to be called from the timer interrupt
+   once the tick count reaches DEADLINE.  A DEADLINE that has
+   already passed fires on the next tick.  EV must not already
+   be pending.  May be called from an interrupt handler. */
+void
+timer_add (struct timer_event *ev, int64_t deadline,
+		timer_func *func, void *aux) {
+	enum intr_level old_level;
+
+	ASSERT (ev != NULL);
+	ASSERT (func != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (!ev->pending);
+	ev->deadline = deadline;
+	ev->func = func;
+	ev->aux = aux;
+	ev->pending = true;
+	wheel_insert (ev);
+	intr_set_level (old_level);
+}
+
+/* Cancels EV if it is still pending.  Returns true if it was
+   cancelled, false if it had already fired or was never added.
+   May be called from an interrupt handler. */
+bool
+timer_cancel (struct timer_event *ev) {
+	enum intr_level old_level;
+	bool was_pending;
+
+	ASSERT (ev != NULL);
+
+	old_level = intr_disable ();
+	was_pending = ev->pending;
+	if (was_pending) {
+		list_remove (&ev->elem);
+		ev->pending = false;
+	}
+	intr_set_level (old_level);
+	return was_pending;
+}
+
+/* Returns the earliest tick at which a pending timer may fire.
+   Only level 0 of the wheel is scanned; timers in the upper
+   levels cannot fire before level 0 next wraps around, so that
+   tick is a safe answer when level 0 is empty. */
+static int64_t
+timer_next_deadline (void) {
+	int64_t t = wheel_clock;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	while ((t & WHEEL_MASK) != 0 && list_empty (&wheel[0][t & WHEEL_MASK]))
+		t++;
+	return t;
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  In tickless mode, replaces the periodic tick by a
+   single interrupt at the next timer deadline, as far out as the
+   8254's 16-bit counter allows.  Whatever interrupt wakes the
+   CPU up calls timer_irq_enter(), which catches up on the ticks
+   that were skipped. */
+void
+timer_idle_enter (void) {
+	int64_t delta;
+	unsigned phase, max_delta;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (!timer_tickless || tick_state != TICK_PERIODIC
+			|| !list_empty (&hr_sleepers))
+		return;
+	if (apic_enabled) {
+		lapic_idle_enter ();
+		return;
+	}
+
+	/* Counts left until the tick that is already under way. */
+	phase = pit_read (NULL);
+	if (phase == 0 || phase > PIT_COUNT)
+		return;
+
+	max_delta = 1 + (UINT16_MAX - phase) / PIT_COUNT;
+	delta = timer_next_deadline () - ticks;
+	if (delta > max_delta)
+		delta = max_delta;
+	if (delta <= 1)
+		return;
+
+	stopped_phase = phase;
+	stopped_count = phase + (delta - 1) * PIT_COUNT;
+	pit_program (0, stopped_count);
+	tick_state = TICK_STOPPED;
+}
+
+/* Called on entry to every external interrupt.  If the tick was
+   stopped by timer_idle_enter(), accounts for the ticks that
+   passed in the meantime and restarts the tick, keeping it in
+   phase with the ticks that were skipped. */
+void
+timer_irq_enter (void) {
+	unsigned elapsed, skipped;
+	bool expired;
+	uint16_t left;
+
+	ASSERT (intr_context ());
+	if (tick_state != TICK_STOPPED)
+		return;
+	if (apic_enabled) {
+		lapic_irq_enter ();
+		return;
+	}
+
+	left = pit_read (&expired);
+	if (expired) {
+		/* The one-shot ran out, and its interrupt is either this
+		   one or still pending.  That interrupt counts the last
+		   tick itself. */
+		skipped = (stopped_count - stopped_phase) / PIT_COUNT;
+		pit_program (2, PIT_COUNT);
+		tick_state = TICK_PERIODIC;
+	} else {
+		/* Woken early by another device.  Count the whole ticks
+		   that passed and finish the current one in one-shot
+		   mode, so that the tick stays in phase. */
+		elapsed = stopped_count - left;
+		if (elapsed < stopped_phase) {
+			skipped = 0;
+			left = stopped_phase - elapsed;
+		} else {
+			skipped = 1 + (elapsed - stopped_phase) / PIT_COUNT;
+			left = PIT_COUNT - (elapsed - stopped_phase) % PIT_COUNT;
+		}
+		pit_program (0, left);
+		tick_state = TICK_RESYNC;
+	}
+
+	while (skipped-- > 0) {
+		ticks++;
+		thread_tick ();
+	}
+	softirq_raise (SOFTIRQ_TIMER);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
@@ -152,40 +373,432 @@ timer_print_stats (void) {
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	if (tick_state == TICK_HRTIMER) {
+		/* A sub-tick sleeper is due, not the tick. */
+		hr_interrupt ();
+		return;
+	}
+
+	if (apic_enabled) {
+		/* Arm the next tick, less however late this interrupt is,
+		   so that the tick does not drift. */
+		uint64_t late = lapic_timer_elapsed () - lapic_armed;
+		if (late >= lapic_tick_counts)
+			late = lapic_tick_counts - 1;
+		lapic_arm (lapic_tick_counts - late);
+		tick_state = TICK_PERIODIC;
+	} else if (tick_state == TICK_RESYNC) {
+		/* Back on a tick boundary: resume periodic mode. */
+		pit_program (2, PIT_COUNT);
+		tick_state = TICK_PERIODIC;
+	}
 	ticks++;
-	thread_tick();
-	thread_wake(ticks);
+	trace_event (TRACE_TICK, thread_current (), ticks);
+	thread_tick ();
+	softirq_raise (SOFTIRQ_TIMER);
+
+	hr_wake ();
+	hr_program ();
 }
 
-/* Returns true if LOOPS iterations waits for more than one timer
-   tick, otherwise false. */
-static bool
-too_many_loops (unsigned loops) {
-	/* Wait for a timer tick. */
-	int64_t start = ticks;
-	while (ticks == start)
-		barrier ();
+/* Programs counter 0 of the 8254 to run in MODE with the given
+   initial COUNT.  Mode 2 interrupts every COUNT input clocks;
+   mode 0 interrupts once, after COUNT input clocks.  See [8254]
+   for details. */
+static void
+pit_program (int mode, uint16_t count) {
+	outb (0x43, 0x30 | (mode << 1)); /* CW: counter 0, LSB then MSB, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
 
-	/* Run LOOPS loops. */
-	start = ticks;
-	busy_wait (loops);
+/* Returns the current value of counter 0 of the 8254.  If
+   EXPIRED is nonnull, sets *EXPIRED to whether its output is
+   high, which in mode 0 means that the count has run out. */
+static uint16_t
+pit_read (bool *expired) {
+	uint8_t status;
+	uint16_t count;
 
-	/* If the tick count changed, we iterated too long. */
-	barrier ();
-	return start != ticks;
+	outb (0x43, 0xc2);  /* Read-back: latch status and count of counter 0. */
+	status = inb (0x40);
+	count = inb (0x40);
+	count |= inb (0x40) << 8;
+	if (expired != NULL)
+		*expired = (status & 0x80) != 0;
+	return count;
+}
+
+/* Busy-waits for COUNT input clocks of the 8254, using counter
+   2, whose gate and output are wired to port 0x61 instead of an
+   interrupt.  Leaves counter 0, the tick, alone. */
+static void
+pit_delay (uint16_t count) {
+	outb (0x61, (inb (0x61) & ~0x02) | 0x01); /* Gate on, speaker off. */
+	outb (0x43, 0xb0);  /* CW: counter 2, LSB then MSB, mode 0, binary. */
+	outb (0x42, count & 0xff);
+	outb (0x42, count >> 8);
+	while (!(inb (0x61) & 0x20))
+		continue;
+}
+
+/* Measures the TSC's rate against 10 ms of the 8254, and starts
+   timer_ns() at 0. */
+static void
+tsc_calibrate (void) {
+	uint64_t start, hz;
+	uint32_t eax, ebx, ecx, edx;
+
+	start = rdtsc ();
+	pit_delay (PIT_HZ / 100);
+	hz = (rdtsc () - start) * PIT_HZ / (PIT_HZ / 100);
+
+	tsc_hz = hz;
+	tsc_mult = (NS_PER_SEC << 32) / hz;
+	tsc_base = rdtsc ();
+
+	/* CPUID.80000007H:EDX[8]: the TSC runs at a constant rate in
+	   every P-, C- and T-state. */
+	cpuid (0x80000000, &eax, &ebx, &ecx, &edx);
+	if (eax >= 0x80000007)
+		cpuid (0x80000007, &eax, &ebx, &ecx, &edx);
+	else
+		edx = 0;
+	printf ("Calibrating timer...  %'"PRIu64" Hz TSC%s.\n",
+			hz, edx & (1u << 8) ? "" : " (not invariant)");
 }
 
-/* Iterates through a simple loop LOOPS times, for implementing
-   brief delays.
+/* Measures the local APIC timer's rate against 10 ms of the
+   8254 and starts the tick.  In TSC-deadline mode, the timer
+   counts TSC cycles, which tsc_calibrate() has already measured. */
+static void
+lapic_tick_init (void) {
+	lapic_timer_init (0x20);
+	if (lapic_timer_tsc_deadline ())
+		lapic_hz = (NS_PER_SEC << 32) / tsc_mult;
+	else {
+		lapic_arm (lapic_timer_max ());
+		pit_delay (PIT_HZ / 100);
+		lapic_hz = lapic_timer_elapsed () * PIT_HZ / (PIT_HZ / 100);
+	}
+
+	lapic_tick_counts = (lapic_hz + TIMER_FREQ / 2) / TIMER_FREQ;
+	ASSERT (lapic_tick_counts > 0);
+	printf ("LAPIC timer: %'"PRIu64" Hz.\n", lapic_hz);
+	lapic_arm (lapic_tick_counts);
+}
 
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE
-busy_wait (int64_t loops) {
-	while (loops-- > 0)
-		barrier ();
+/* Arms the local APIC timer for COUNTS clocks. */
+static void
+lapic_arm (uint64_t counts) {
+	lapic_armed = counts;
+	lapic_timer_set (counts);
+}
+
+/* timer_idle_enter() for the local APIC timer.  The tick under
+   way ends when the one-shot armed for it expires; the stopped
+   tick is armed to end at the next timer deadline instead. */
+static void
+lapic_idle_enter (void) {
+	uint64_t elapsed = lapic_timer_elapsed ();
+	int64_t delta, max_delta;
+
+	if (elapsed >= lapic_armed)
+		return;
+	lapic_phase = lapic_armed - elapsed;
+
+	max_delta = 1 + (lapic_timer_max () - lapic_phase) / lapic_tick_counts;
+	delta = timer_next_deadline () - ticks;
+	if (delta > max_delta)
+		delta = max_delta;
+	if (delta <= 1)
+		return;
+
+	lapic_arm (lapic_phase + (delta - 1) * lapic_tick_counts);
+	tick_state = TICK_STOPPED;
+}
+
+/* timer_irq_enter() for the local APIC timer.  Unlike the 8254,
+   the timer needs no mode change to get back in phase: it is
+   simply armed for the rest of the current tick, and
+   timer_interrupt() takes over from there. */
+static void
+lapic_irq_enter (void) {
+	uint64_t elapsed = lapic_timer_elapsed ();
+	int64_t skipped;
+
+	if (elapsed >= lapic_armed) {
+		/* Expired: that interrupt counts the last tick itself. */
+		skipped = (lapic_armed - lapic_phase) / lapic_tick_counts;
+	} else if (elapsed < lapic_phase) {
+		skipped = 0;
+		lapic_arm (lapic_phase - elapsed);
+	} else {
+		skipped = 1 + (elapsed - lapic_phase) / lapic_tick_counts;
+		lapic_arm (lapic_tick_counts
+				- (elapsed - lapic_phase) % lapic_tick_counts);
+	}
+	tick_state = TICK_PERIODIC;
+
+	while (skipped-- > 0) {
+		ticks++;
+		thread_tick ();
+	}
+	softirq_raise (SOFTIRQ_TIMER);
+}
+
+/* Returns the number of tick timer clocks in NS nanoseconds,
+   rounded up.  NS must not exceed a tick. */
+static uint64_t
+ns_to_clocks (uint64_t ns) {
+	uint64_t hz = apic_enabled ? lapic_hz : PIT_HZ;
+	return (ns * hz + NS_PER_SEC - 1) / NS_PER_SEC;
+}
+
+/* Returns the number of tick timer clocks until its next
+   interrupt, or 0 if that interrupt is already due. */
+static uint64_t
+clocks_left (void) {
+	bool expired;
+	uint16_t left;
+
+	if (apic_enabled) {
+		uint64_t elapsed = lapic_timer_elapsed ();
+		return elapsed < lapic_armed ? lapic_armed - elapsed : 0;
+	}
+
+	/* The 8254 reloads in periodic mode without a trace, so ask
+	   the master 8259A whether IRQ 0 is pending instead. */
+	outb (0x20, 0x0a);  /* OCW3: read IRR. */
+	if (inb (0x20) & 0x01)
+		return 0;
+	left = pit_read (&expired);
+	if (tick_state != TICK_PERIODIC && expired)
+		return 0;
+	return left < PIT_COUNT || tick_state != TICK_PERIODIC ? left : PIT_COUNT;
+}
+
+/* Returns the number of tick timer clocks since the one-shot
+   interrupt being handled was due. */
+static uint64_t
+clocks_late (void) {
+	if (apic_enabled) {
+		uint64_t elapsed = lapic_timer_elapsed ();
+		return elapsed > lapic_armed ? elapsed - lapic_armed : 0;
+	}
+
+	/* In mode 0, the 8254 keeps counting down past zero. */
+	return (uint16_t) -pit_read (NULL);
+}
+
+/* Arms the tick timer for a single interrupt after COUNTS
+   clocks. */
+static void
+clocks_arm (uint64_t counts) {
+	if (counts == 0)
+		counts = 1;
+	if (apic_enabled)
+		lapic_arm (counts);
+	else
+		pit_program (0, counts > UINT16_MAX ? UINT16_MAX : counts);
+}
+
+/* Blocks the current thread for NS nanoseconds, which is less
+   than a tick, on a one-shot interrupt of the tick timer. */
+static void
+hr_sleep (uint64_t ns) {
+	struct hr_sleeper s;
+	struct list_elem *e;
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	s.wake_ns = timer_ns () + ns;
+	s.thread = thread_current ();
+	for (e = list_begin (&hr_sleepers); e != list_end (&hr_sleepers);
+			e = list_next (e))
+		if (list_entry (e, struct hr_sleeper, elem)->wake_ns > s.wake_ns)
+			break;
+	list_insert (e, &s.elem);
+
+	hr_program ();
+	thread_block ();
+	intr_set_level (old_level);
+}
+
+/* Wakes every sub-tick sleeper that is due. */
+static void
+hr_wake (void) {
+	uint64_t now = timer_ns ();
+	bool woke = false;
+
+	while (!list_empty (&hr_sleepers)) {
+		struct hr_sleeper *s = list_entry (list_front (&hr_sleepers),
+				struct hr_sleeper, elem);
+		if (s->wake_ns > now)
+			break;
+		list_pop_front (&hr_sleepers);
+		thread_unblock (s->thread);
+		woke = true;
+	}
+	if (woke)
+		test_max_priority ();
+}
+
+/* Returns the number of tick timer clocks until the first
+   sub-tick sleeper is due, or UINT64_MAX if there is none. */
+static uint64_t
+hr_next (void) {
+	struct hr_sleeper *s;
+	uint64_t now;
+
+	if (list_empty (&hr_sleepers))
+		return UINT64_MAX;
+	s = list_entry (list_front (&hr_sleepers), struct hr_sleeper, elem);
+	now = timer_ns ();
+	if (s->wake_ns <= now)
+		return 1;
+	if (s->wake_ns - now > NS_PER_TICK)
+		return UINT64_MAX;
+	return ns_to_clocks (s->wake_ns - now);
+}
+
+/* If the first sub-tick sleeper is due before the tick timer's
+   next interrupt, rearms the timer to interrupt for it first.
+   hr_phase keeps track of the rest of the tick. */
+static void
+hr_program (void) {
+	uint64_t next, left;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (tick_state == TICK_STOPPED)
+		return;
+
+	next = hr_next ();
+	if (next == UINT64_MAX)
+		return;
+	left = clocks_left ();
+	if (next >= left)
+		return;
+
+	if (tick_state == TICK_HRTIMER)
+		hr_phase += left - next;
+	else
+		hr_phase = left - next;
+	tick_state = TICK_HRTIMER;
+	clocks_arm (next);
+}
+
+/* Handles a TICK_HRTIMER interrupt: wakes the sleepers that are
+   due, then arms the timer for the next sleeper in this tick, or
+   else for the rest of the tick. */
+static void
+hr_interrupt (void) {
+	uint64_t late = clocks_late (), next;
+
+	hr_phase = hr_phase > late ? hr_phase - late : 1;
+	hr_wake ();
+
+	next = hr_next ();
+	if (next < hr_phase) {
+		hr_phase -= next;
+		clocks_arm (next);
+	} else {
+		tick_state = TICK_RESYNC;
+		clocks_arm (hr_phase);
+	}
+}
+
+/* Puts EV into the wheel slot that covers its deadline.  Timers
+   whose deadline has passed go into the slot processed next. */
+static void
+wheel_insert (struct timer_event *ev) {
+	int64_t deadline = ev->deadline;
+	int64_t delta = deadline - wheel_clock;
+	int level;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (delta < 0)
+		deadline = wheel_clock;
+	else if (delta >= (1LL << (WHEEL_BITS * WHEEL_LEVELS)))
+		deadline = wheel_clock + (1LL << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (deadline - wheel_clock < (1LL << (WHEEL_BITS * (level + 1))))
+			break;
+
+	list_push_back (&wheel[level][(deadline >> (WHEEL_BITS * level))
+			& WHEEL_MASK], &ev->elem);
+}
+
+/* Moves every timer in SLOT onto the list LIST. */
+static void
+wheel_take_slot (struct list *slot, struct list *list) {
+	list_init (list);
+	if (!list_empty (slot))
+		list_splice (list_end (list), list_begin (slot), list_end (slot));
+}
+
+/* Redistributes the timers in slot INDEX of LEVEL into the
+   lower levels.  Returns INDEX, so that the caller knows whether
+   the next level up has wrapped around too. */
+static int
+wheel_cascade (int level, int index) {
+	struct list cascaded;
+
+	wheel_take_slot (&wheel[level][index], &cascaded);
+	while (!list_empty (&cascaded))
+		wheel_insert (list_entry (list_pop_front (&cascaded),
+					struct timer_event, elem));
+	return index;
+}
+
+/* Timer softirq, raised by every tick: fires the timer_events
+   that are due, outside the hard interrupt handler. */
+static void
+timer_softirq (void) {
+	enum intr_level old_level = intr_disable ();
+	wheel_run (ticks);
+	intr_set_level (old_level);
+}
+
+/* Fires every timer whose deadline is at most NOW.  Normally
+   this processes exactly one tick, but it catches up if ticks
+   were skipped.  Timer functions run with interrupts off, but
+   pending interrupts are let in between them. */
+static void
+wheel_run (int64_t now) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (wheel_clock <= now) {
+		int index = wheel_clock & WHEEL_MASK;
+		struct list expired;
+		int level;
+
+		/* Level 0 wrapped around: refill it from the levels above. */
+		for (level = 1; index == 0 && level < WHEEL_LEVELS; level++)
+			index = wheel_cascade (level,
+					(wheel_clock >> (WHEEL_BITS * level)) & WHEEL_MASK);
+
+		/* Detach the slot first, so that a callback that re-adds
+		   its own timer for a past deadline does not land in the
+		   list we are walking. */
+		wheel_take_slot (&wheel[0][wheel_clock & WHEEL_MASK], &expired);
+		wheel_clock++;
+		while (!list_empty (&expired)) {
+			struct timer_event *ev = list_entry (list_pop_front (&expired),
+					struct timer_event, elem);
+			ev->pending = false;
+			ev->func (ev->aux);
+
+			/* EXPIRED is detached from the wheel, so an interrupt
+			   handler may add or cancel timers here. */
+			intr_enable ();
+			intr_disable ();
+		}
+	}
 }
 
 /* Sleep for approximately NUM/DENOM seconds. */
@@ -200,16 +813,27 @@ real_time_sleep (int64_t num, int32_t denom) {
 	int64_t ticks = num * TIMER_FREQ / denom;
 
 	ASSERT (intr_get_level () == INTR_ON);
+	/* 0 이하의 시간은 바로 반환한다. 아래의 나노초 계산은 unsigned라서
+	   음수 NUM이 거대한 값으로 바뀌어 hr_sleep()이 돌아오지 않는다. */
+	if (num <= 0)
+		return;
 	if (ticks > 0) {
 		/* We're waiting for at least one full timer tick.  Use
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
 		timer_sleep (ticks);
 	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
-		ASSERT (denom % 1000 == 0);
-		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+		/* Otherwise, block until a one-shot interrupt for more
+		   accurate sub-tick timing, unless the sleep is too short
+		   to be worth switching threads for. */
+		uint64_t ns = num * (NS_PER_SEC / denom);
+
+		if (ns >= HR_SLEEP_MIN_NS)
+			hr_sleep (ns);
+		else {
+			uint64_t end = timer_ns () + ns;
+			while (timer_ns () < end)
+				barrier ();
+		}
 	}
 }
@@ -1,23 +1,52 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* -tickless: stop the periodic tick while the CPU is idle? */
+extern bool timer_tickless;
+
+/* Function called when a timer expires.  It runs in the timer
+   softirq, in interrupt context with interrupts off, so it must
+   not sleep. */
+typedef void timer_func (void *aux);
+
+/* A one-shot timer, queued on the timer wheel by timer_add().
+   The caller owns the storage, which must stay valid until the
+   timer fires or is cancelled. */
+struct timer_event {
+	struct list_elem elem;      /* Element in a timer wheel slot. */
+	int64_t deadline;           /* Tick at which to fire. */
+	timer_func *func;           /* Function to call. */
+	void *aux;                  /* Argument for FUNC. */
+	bool pending;               /* Queued and not yet fired? */
+};
+
 void timer_init (void);
-void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+uint64_t timer_ns (void);
+uint64_t timer_tsc_hz (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_add (struct timer_event *, int64_t deadline,
+                timer_func *, void *aux);
+bool timer_cancel (struct timer_event *);
+
+void timer_idle_enter (void);
+void timer_irq_enter (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
@@ -0,0 +1,75 @@
+#ifndef __LIB_KERNEL_PHEAP_H
+#define __LIB_KERNEL_PHEAP_H
+
+/* Pairing heap.
+ *
+ * A max-heap that supports insertion in O(1) time, finding the
+ * greatest element in O(1) time, and removal of the greatest or
+ * of an arbitrary element in O(log n) amortized time.  An
+ * element whose key has changed is put back in order by
+ * pheap_update(), also in O(log n) amortized time, which makes
+ * the heap suitable for keys such as thread priorities that
+ * change while the element is queued.
+ *
+ * Like the linked list in list.h, the heap does not use dynamic
+ * allocation.  Each structure that can be in a heap must embed
+ * a struct pheap_elem member, and the pheap_entry macro converts
+ * a struct pheap_elem back to the structure that contains it.
+ *
+ * Elements that compare equal come out in no particular order.
+ * Callers that need FIFO order among equal keys must break ties
+ * in their comparison function. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Pairing heap element. */
+struct pheap_elem {
+	struct pheap_elem *child;   /* First child, or null. */
+	struct pheap_elem *next;    /* Next sibling, or null. */
+	struct pheap_elem *prev;    /* Previous sibling, or parent if
+	                               first child, or null for the root. */
+};
+
+/* Converts pointer to heap element PHEAP_ELEM into a pointer to
+ * the structure that PHEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define pheap_entry(PHEAP_ELEM, STRUCT, MEMBER)     \
+	((STRUCT *) ((uint8_t *) (PHEAP_ELEM)           \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool pheap_less_func (const struct pheap_elem *a,
+		const struct pheap_elem *b,
+		void *aux);
+
+/* Performs some operation on heap element E, given auxiliary
+ * data AUX. */
+typedef void pheap_action_func (struct pheap_elem *e, void *aux);
+
+/* Pairing heap. */
+struct pheap {
+	struct pheap_elem *root;    /* Greatest element, or null if empty. */
+	size_t elem_cnt;            /* Number of elements. */
+	pheap_less_func *less;      /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void pheap_init (struct pheap *, pheap_less_func *, void *aux);
+
+void pheap_insert (struct pheap *, struct pheap_elem *);
+void pheap_remove (struct pheap *, struct pheap_elem *);
+void pheap_update (struct pheap *, struct pheap_elem *);
+
+struct pheap_elem *pheap_top (struct pheap *);
+struct pheap_elem *pheap_pop (struct pheap *);
+void pheap_drain (struct pheap *, pheap_action_func *, void *aux);
+
+size_t pheap_size (struct pheap *);
+bool pheap_empty (struct pheap *);
+
+#endif /* lib/kernel/pheap.h */
@@ -0,0 +1,66 @@
+#ifndef __LIB_KERNEL_PQUEUE_H
+#define __LIB_KERNEL_PQUEUE_H
+
+/* Priority wait queue.
+ *
+ * A queue whose elements carry an integer key, such as a thread
+ * priority, built on the pairing heap in pheap.h.  pq_pop()
+ * returns the element with the greatest key, and the element
+ * pushed first among those with equal keys, so a queue of
+ * threads that all share one priority is plain FIFO.
+ *
+ * pq_push() and pq_top() take O(1) time.  pq_pop(), pq_remove()
+ * and pq_rekey() take O(log n) amortized time.  pq_rekey()
+ * changes the key of an element that is already queued, for
+ * example when a waiting thread receives a priority donation,
+ * and keeps its place in FIFO order among equal keys.
+ * pq_drain() empties the whole queue in O(n) time, but visits
+ * the elements in no particular order.
+ *
+ * Like the other kernel containers, the queue does not use
+ * dynamic allocation: each structure that can be queued embeds
+ * a struct pqueue_elem, and pq_entry converts back. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pheap.h"
+
+/* Priority queue element. */
+struct pqueue_elem {
+	struct pheap_elem heap_elem;    /* Element in the heap. */
+	int key;                        /* Greater keys come out first. */
+	uint64_t seq;                   /* Push order, for FIFO among equals. */
+};
+
+/* Converts pointer to queue element PQUEUE_ELEM into a pointer
+ * to the structure that PQUEUE_ELEM is embedded inside.  Supply
+ * the name of the outer structure STRUCT and the member name
+ * MEMBER of the queue element. */
+#define pq_entry(PQUEUE_ELEM, STRUCT, MEMBER)       \
+	((STRUCT *) ((uint8_t *) (PQUEUE_ELEM)          \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Performs some operation on queue element E, given auxiliary
+ * data AUX. */
+typedef void pq_action_func (struct pqueue_elem *e, void *aux);
+
+/* Priority queue. */
+struct pqueue {
+	struct pheap heap;              /* Elements, by key then seq. */
+	uint64_t next_seq;              /* Sequence number for next push. */
+};
+
+void pq_init (struct pqueue *);
+
+void pq_push (struct pqueue *, struct pqueue_elem *, int key);
+struct pqueue_elem *pq_top (struct pqueue *);
+struct pqueue_elem *pq_pop (struct pqueue *);
+void pq_remove (struct pqueue *, struct pqueue_elem *);
+void pq_rekey (struct pqueue *, struct pqueue_elem *, int key);
+void pq_drain (struct pqueue *, pq_action_func *, void *aux);
+
+size_t pq_size (struct pqueue *);
+bool pq_empty (struct pqueue *);
+
+#endif /* lib/kernel/pqueue.h */
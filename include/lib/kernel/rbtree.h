@@ -0,0 +1,67 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+ *
+ * A balanced binary search tree: insertion and removal take
+ * O(log n) time.  The tree also caches its leftmost (minimum)
+ * element, so finding the minimum takes O(1) time, which makes
+ * it suitable as a priority queue that must also support
+ * removal of arbitrary elements.
+ *
+ * Like the linked list in list.h, the tree does not use dynamic
+ * allocation.  Each structure that can be in a tree must embed
+ * a struct rb_elem member, and the rb_entry macro converts a
+ * struct rb_elem back to the structure that contains it.
+ *
+ * Elements that compare equal are kept in insertion order: a
+ * new element goes after every element it is not less than. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Red-black tree element. */
+struct rb_elem {
+	struct rb_elem *parent;     /* Parent, or null for the root. */
+	struct rb_elem *left;       /* Left child, or null. */
+	struct rb_elem *right;      /* Right child, or null. */
+	bool red;                   /* Red or black? */
+};
+
+/* Converts pointer to tree element RB_ELEM into a pointer to
+ * the structure that RB_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the tree element. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) (RB_ELEM)              \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two tree elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_elem *a,
+		const struct rb_elem *b,
+		void *aux);
+
+/* Red-black tree. */
+struct rbtree {
+	struct rb_elem *root;       /* Root, or null if empty. */
+	struct rb_elem *min;        /* Leftmost element, or null. */
+	size_t elem_cnt;            /* Number of elements. */
+	rb_less_func *less;         /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void rb_init (struct rbtree *, rb_less_func *, void *aux);
+
+void rb_insert (struct rbtree *, struct rb_elem *);
+void rb_remove (struct rbtree *, struct rb_elem *);
+
+struct rb_elem *rb_min (struct rbtree *);
+struct rb_elem *rb_next (struct rb_elem *);
+
+size_t rb_size (struct rbtree *);
+bool rb_empty (struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
@@ -36,6 +36,18 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Real-time scheduling. */
+	SYS_SET_DEADLINE,           /* Reserve CPU time under EDF. */
+
+	/* User-space synchronization. */
+	SYS_FUTEX_WAIT,             /* Sleep if an int holds a value. */
+	SYS_FUTEX_WAKE,             /* Wake threads sleeping on an int. */
+
+	/* User threads. */
+	SYS_THREAD_CREATE,          /* Start a thread in this process. */
+	SYS_THREAD_JOIN,            /* Wait for a thread to exit. */
+	SYS_THREAD_EXIT,            /* Exit the calling thread only. */
 };
 
 #endif /* lib/syscall-nr.h */
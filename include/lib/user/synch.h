@@ -0,0 +1,37 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* Mutexes and condition variables for user programs, built on
+   the futex_wait() and futex_wake() system calls.  Locking and
+   unlocking a mutex that no other thread wants, and signaling a
+   condition that nobody waits on, never enter the kernel. */
+
+/* Mutex. */
+struct mutex {
+	int state;                  /* 0: unlocked, 1: locked,
+	                               2: locked, maybe with sleepers. */
+};
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* Condition variable. */
+struct cond {
+	int seq;                    /* Bumped by every signal. */
+	int waiters;                /* Threads in cond_wait(). */
+};
+
+#define COND_INITIALIZER { 0, 0 }
+
+void cond_init (struct cond *);
+void cond_wait (struct cond *, struct mutex *);
+void cond_signal (struct cond *);
+void cond_broadcast (struct cond *);
+
+#endif /* lib/user/synch.h */
@@ -50,6 +50,31 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Real-time scheduling. */
+bool set_deadline (long long runtime, long long period);
+
+/* User-space synchronization.  See lib/user/synch.h for locks
+   built on these. */
+#define FUTEX_WOKEN 0               /* Woken by futex_wake(). */
+#define FUTEX_AGAIN -1              /* *ADDR did not hold EXPECTED. */
+#define FUTEX_TIMEDOUT -2           /* TIMEOUT ticks passed first. */
+#define FUTEX_FAULT -3              /* ADDR is not a mapped int.  A
+                                       page not touched yet counts
+                                       as unmapped. */
+int futex_wait (int *addr, int expected, long long timeout);
+int futex_wake (int *addr, int n);
+
+/* User threads, which share the process's memory.  STACK_SIZE
+   bytes at STACK become the new thread's stack; they must stay
+   valid until the thread exits.  A thread that returns from FUNC
+   exits as if by thread_exit().  When the process's first thread
+   exits, every other thread exits with it. */
+typedef void user_thread_func (void *aux);
+pid_t thread_create (user_thread_func *func, void *aux,
+		void *stack, size_t stack_size);
+int thread_join (pid_t);
+void thread_exit (void) NO_RETURN;
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,23 @@
+#ifndef THREADS_APIC_H
+#define THREADS_APIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* If true, deliver interrupts through the local APIC and I/O
+   APIC instead of the 8259A PICs, and drive the timer tick from
+   the local APIC timer.  Controlled by kernel command-line option
+   "-apic".  apic_init() clears it if the CPU has no APIC. */
+extern bool apic_enabled;
+
+void apic_init (void);
+void apic_eoi (void);
+void ioapic_route (int irq, uint8_t vec);
+
+void lapic_timer_init (uint8_t vec);
+bool lapic_timer_tsc_deadline (void);
+void lapic_timer_set (uint64_t counts);
+uint64_t lapic_timer_elapsed (void);
+uint64_t lapic_timer_max (void);
+
+#endif /* threads/apic.h */
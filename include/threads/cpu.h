@@ -0,0 +1,77 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <list.h>
+#include <rbtree.h>
+#include <stdint.h>
+#include "threads/thread.h"
+
+/* Maximum number of CPUs. */
+#define CPU_MAX 16
+
+#if PRI_MAX >= 64
+#error ready_mask requires PRI_MAX < 64
+#endif
+
+/* A CPU's run queue of threads in THREAD_READY state, that is,
+   threads that are ready to run but not actually running.
+   Owned by thread.c.
+
+   For the priority schedulers there is one FIFO list per
+   priority level, and bit N of ready_mask is set if and only if
+   ready_queues[N] is nonempty, so finding the highest-priority
+   ready thread is a single find-first-set on the mask.  The CFS
+   and EDF classes keep their threads in red-black trees. */
+struct runqueue {
+	struct list ready_queues[PRI_MAX + 1];
+	uint64_t ready_mask;
+	int ready_cnt;              /* # of threads in all of the queues. */
+
+	struct rbtree cfs_queue;    /* CFS threads, by vruntime. */
+	unsigned cfs_load;          /* Total weight of threads in cfs_queue. */
+	int64_t cfs_min_vruntime;   /* Never decreasing floor of vruntimes. */
+
+	struct rbtree dl_queue;     /* EDF threads, by deadline. */
+};
+
+struct trace_buf;
+
+/* Per-CPU data.  Each CPU's GS base points to its struct cpu,
+   so that cpu_current() is a single load no matter which thread
+   is running. */
+struct cpu {
+	struct cpu *self;           /* This struct, for cpu_current(). */
+	int id;                     /* Index in cpus[]. */
+
+	struct thread *curr;        /* Running thread. */
+	struct runqueue rq;         /* Ready threads. */
+	struct thread *idle_thread; /* Runs when rq is empty. */
+	unsigned thread_ticks;      /* # of timer ticks since last yield. */
+
+	/* Statistics. */
+	long long idle_ticks;       /* # of timer ticks spent idle. */
+	long long kernel_ticks;     /* # of timer ticks in kernel threads. */
+	long long user_ticks;       /* # of timer ticks in user programs. */
+	long long idle_wakeups;     /* # of times the idle thread woke up. */
+
+#ifdef SCHED_TRACE
+	struct trace_buf *trace;    /* Event ring buffer, see trace.h. */
+#endif
+};
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt;
+
+void cpu_init (void);
+
+/* Returns the CPU we are running on.  Callers that need the
+   answer to stay true must keep interrupts off, since a thread
+   may otherwise be moved to another CPU. */
+static inline struct cpu *
+cpu_current (void) {
+	struct cpu *c;
+	asm volatile ("movq %%gs:0, %0" : "=r" (c));
+	return c;
+}
+
+#endif /* threads/cpu.h */
@@ -11,6 +11,10 @@ enum palloc_flags {
 	PAL_USER = 004              /* User page. */
 };
 
+/* Largest block the buddy allocator manages is 2**PALLOC_MAX_ORDER
+   pages; palloc_get_multiple() cannot allocate more at once. */
+#define PALLOC_MAX_ORDER 12
+
 /* Maximum number of pages to put in user pool. */
 extern size_t user_page_limit;
 
@@ -19,5 +23,10 @@ void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_print_stats (void);
+size_t palloc_free_blocks (enum palloc_flags, int order);
+void palloc_start_zeroing (void);
+void palloc_zero_stats (enum palloc_flags, long long *hits,
+		long long *misses);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,43 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* Slab allocator: caches of fixed-size objects.  See slab.c. */
+
+/* Empty slabs kept per cache. */
+#define SLAB_EMPTY_MAX 1
+
+/* Constructor run once on every object of a new slab. */
+typedef void kmem_ctor_func (void *obj);
+
+/* A cache of objects of one size. */
+struct kmem_cache {
+	char name[16];              /* Name, for statistics. */
+	size_t obj_size;            /* Size requested by the creator. */
+	size_t size;                /* Stride between objects. */
+	size_t align;               /* Alignment of each object. */
+	kmem_ctor_func *ctor;       /* Constructor, or NULL. */
+	size_t objs_per_slab;       /* Objects in each page-sized slab. */
+	size_t first_ofs;           /* Offset of the first object in a slab. */
+
+	struct lock lock;           /* Protects everything below. */
+	struct list partial;        /* Slabs with used and free objects. */
+	struct list full;           /* Slabs with no free objects. */
+	struct list empty;          /* Slabs with no used objects. */
+	size_t slab_cnt;            /* Slabs on all three lists. */
+	size_t empty_cnt;           /* Slabs on `empty'. */
+	size_t in_use;              /* Objects allocated. */
+	struct list_elem elem;      /* Element in the list of all caches. */
+};
+
+void slab_init (void);
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor_func *ctor);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_cache_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -0,0 +1,36 @@
+#ifndef THREADS_SOFTIRQ_H
+#define THREADS_SOFTIRQ_H
+
+#include <stdbool.h>
+
+/* Softirqs: the second half of external interrupt handling.
+
+   A hard interrupt handler does only what cannot wait, such as
+   reading the device, and raises a softirq for the rest.
+   Raised softirqs run as the interrupt returns, after the
+   interrupt controller has been acknowledged and with
+   interrupts turned back on, so other devices are not held off
+   while they run.  intr_yield_on_return() still works from a
+   softirq, and takes effect once all of them are done.
+
+   Softirqs do not nest: an interrupt that arrives during one
+   leaves its raised softirqs for the running round to pick up.
+   Like hard interrupt handlers, softirq handlers run in
+   interrupt context and must not sleep. */
+
+/* Softirq types, in the order they run. */
+enum softirq_type {
+	SOFTIRQ_TIMER,              /* Expired timer_events. */
+	SOFTIRQ_SCHED,              /* Once-a-second scheduler work. */
+	SOFTIRQ_CNT
+};
+
+typedef void softirq_func (void);
+
+void softirq_register (enum softirq_type, softirq_func *, const char *name);
+void softirq_raise (enum softirq_type);
+void softirq_run (void);
+bool softirq_active (void);
+void softirq_print_stats (void);
+
+#endif /* threads/softirq.h */
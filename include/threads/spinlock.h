@@ -0,0 +1,62 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <debug.h>
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+/* Spinlock.
+
+   For critical sections of a few instructions, where blocking
+   on a struct lock would cost far more than the section itself.
+   spin_lock() turns interrupts off before it spins, so the
+   section may be shared with interrupt handlers and the holder
+   cannot be preempted, and spin_unlock() restores the previous
+   interrupt level.  Holding a spinlock therefore also excludes
+   other threads on this CPU; the atomic exchange excludes other
+   CPUs.
+
+   The holder must not sleep, and nested spinlocks must be
+   released in the reverse order that they were acquired. */
+struct spinlock {
+	volatile int locked;        /* 1 if held, 0 otherwise. */
+	enum intr_level old_level;  /* Interrupt level to restore on unlock. */
+};
+
+/* Initializes SL as unheld. */
+static inline void
+spin_init (struct spinlock *sl) {
+	sl->locked = 0;
+}
+
+/* Acquires SL, disabling interrupts and spinning until it is
+   free. */
+static inline void
+spin_lock (struct spinlock *sl) {
+	enum intr_level old_level = intr_disable ();
+
+	while (__atomic_exchange_n (&sl->locked, 1, __ATOMIC_ACQUIRE))
+		while (sl->locked)
+			asm volatile ("pause" : : : "memory");
+	sl->old_level = old_level;
+}
+
+/* Releases SL, which must be held, and restores the interrupt
+   level from before spin_lock(). */
+static inline void
+spin_unlock (struct spinlock *sl) {
+	enum intr_level old_level = sl->old_level;
+
+	ASSERT (sl->locked);
+	__atomic_store_n (&sl->locked, 0, __ATOMIC_RELEASE);
+	intr_set_level (old_level);
+}
+
+/* Returns true if SL is held.  Only meaningful to the holder,
+   for assertions. */
+static inline bool
+spin_held (const struct spinlock *sl) {
+	return sl->locked && intr_get_level () == INTR_OFF;
+}
+
+#endif /* threads/spinlock.h */
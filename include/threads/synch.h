@@ -2,7 +2,10 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <pheap.h>
+#include <pqueue.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
@@ -12,7 +15,7 @@ struct semaphore {
 	//다른 스레드나 프로세스에 의해 사용중이라서 대기 상태인 프로세스나 스레드를 말함
 	// 이들은 세마포어값이 증가하여(공유 자원이 사용 가능해짐을 나타내는 시그널을 받으면서)
 	// 그들이 대기하고 있는 작업을 진행할 수 있게됨
-	struct list waiters;        /* List of waiting threads. */ // 연결리스트에있는 노드가 쓰레드다.
+	struct pqueue waiters;      /* Waiting threads, by priority. */ // 큐에 있는 원소가 쓰레드다.
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -21,21 +24,98 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+/* Something a thread holds whose waiters donate their priority
+   to it: a lock, or one thread's hold on a reader-writer lock.
+   The priority donated is that of the highest waiter in either
+   queue. */
+struct hold {
+	struct pheap_elem elem;     /* Element in holder's held_locks. */
+	struct pqueue *waiters[2];  /* Donating queues; second may be NULL. */
+};
+
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+
+	/* Priority donation, unless thread_mlfqs.  The threads that
+	   donate to the holder are the semaphore's waiters. */
+	struct hold hold;           /* Entry in holder's held_locks. */
+
+	/* Adaptive mode, see lock_set_adaptive(). */
+	bool adaptive;              /* Spin while the holder runs? */
+	unsigned long long spin_acquires; /* Contended, but got it spinning. */
+	unsigned long long spin_blocks; /* Contended, and had to block. */
+
+#ifdef LOCK_STAT
+	struct lock_stat *stat;     /* Statistics for lock_init() site. */
+	uint64_t acquired_at;       /* TSC when the holder acquired it. */
+#endif
+};
+
+#ifdef LOCK_STAT
+/* Contention statistics shared by every lock initialized at one
+   lock_init() call site, with `make LOCK_STAT=1'.  Times are in
+   TSC cycles.  lock_stat_print() reports them at power off. */
+struct lock_stat {
+	const char *file;           /* lock_init() call site. */
+	int line;
+	unsigned long long acquired; /* Successful acquires. */
+	unsigned long long contended; /* Acquires that had to wait. */
+	uint64_t wait_total;        /* Time spent waiting to acquire. */
+	uint64_t wait_max;          /* Longest single wait. */
+	uint64_t hold_total;        /* Time spent holding. */
 };
 
+void lock_init_at (struct lock *, const char *file, int line);
+#define lock_init(LOCK) lock_init_at (LOCK, __FILE__, __LINE__)
+void lock_stat_print (void);
+#else
 void lock_init (struct lock *);
+#endif
+void lock_set_adaptive (struct lock *);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Reader-writer lock.  Any number of readers, or one writer, may
+   hold it at a time.  Writers take precedence: once a writer is
+   waiting, new readers wait behind it, so a steady stream of
+   readers cannot starve writers.  Waiters of either kind donate
+   their priority to every current holder. */
+struct rwlock {
+	struct thread *writer;      /* Writer holding the lock, or NULL. */
+	unsigned readers;           /* Number of readers holding it. */
+	unsigned writers_waiting;   /* Writers in rw_write_acquire(). */
+	struct list holders;        /* struct rw_hold of every holder. */
+	struct pqueue read_waiters; /* Blocked readers, by priority. */
+	struct pqueue write_waiters; /* Blocked writers, by priority. */
+};
+
+/* Most reader-writer locks one thread may hold at once. */
+#define RW_HOLD_MAX 4
+
+/* One thread's hold on a reader-writer lock.  Every thread has
+   RW_HOLD_MAX of these, since any number of threads may share a
+   read hold and the lock cannot embed one per reader. */
+struct rw_hold {
+	struct rwlock *rw;          /* Lock held, or NULL if slot is free. */
+	struct thread *thread;      /* Holder. */
+	struct list_elem elem;      /* Element in rw->holders. */
+	struct hold hold;           /* Entry in thread's held_locks. */
+};
+
+void rw_init (struct rwlock *);
+void rw_read_acquire (struct rwlock *);
+void rw_read_release (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_write_release (struct rwlock *);
+bool rw_write_held_by_current_thread (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct pqueue waiters;      /* Waiting threads, by priority. */
 };
 
 void cond_init (struct condition *);
@@ -3,8 +3,14 @@
 
 #include <debug.h>
 #include <list.h>
+#include <pheap.h>
+#include <pqueue.h>
+#include <rbtree.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
+#include "threads/fixed-point.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -29,6 +35,15 @@ typedef int tid_t;			  // 스레드의 아이디
 #define PRI_DEFAULT 31 /* Default priority. 초기값(절반) */
 #define PRI_MAX 63	   /* Highest priority. */
 
+/* Thread niceness, for the MLFQS. */
+#define NICE_MIN -20	 /* Least nice to other threads. */
+#define NICE_DEFAULT 0	 /* Default niceness. */
+#define NICE_MAX 20		 /* Nicest to other threads. */
+
+/* Buckets in a wakeup latency histogram: the last one also
+   counts every latency of 2**31 cycles or more. */
+#define LATENCY_BUCKETS 32
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page(페이지).  The
@@ -80,12 +95,11 @@ typedef int tid_t;			  // 스레드의 아이디
  * the `magic' member of the running thread's `struct thread' is
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
-/* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+/* The `elem' member is an element in the run queue (thread.c).
+ * A thread blocked on a semaphore waits in the semaphore's
+ * priority queue through `wait_elem' instead (synch.c), and
+ * `waitq' points at whichever queue it is waiting in so that a
+ * priority donation can re-key it there. */
 struct thread
 {
 	/* Owned by thread.c. */
@@ -96,30 +110,50 @@ struct thread
 	// 후에 다시 Thread A가 실행되는 순간에 STack의 값들이 다시 CPU의 register로 로드되어 실행을 이어나갈 수 있다.
 	char name[16];		 /* Name (for debugging purposes). */
 	int priority;		 /* Priority. */
-	int64_t wakeup_tick; // 일어날 시각 추가;
-	// 현재 틱을 확인하는 변수를 추가해야됨.
-	// tic++ 되는게 thread_tick 뭐가 실행될때마다 틱이 올라감.
-	// 레디큐, 블락드에는 틱이 안올라감
-	// 현재 실행중인것만 틱이 올라감
-	// 틱 = 실행되고있는동안 얼마나 시간이 경과됬는지가 틱임
-	// 콘솔에 찍히는게 틱이다.아하
-	// 레디큐에 넣는것 자체가 꺠우는것이다.
-	// 블락드 리스트에서 레디로 가는것을 스케줄링 하는것,
-	// 조건을 달아서 언제 얘를 꺠울것이냐,
-	// 그 기준이 틱인데
-	// 현재 돌아가고있는 쓰레드의 틱과, 블락드 리스트의 가장 앞에 있는 스레드의 틱을 비교해서
-	// 현재 스레드보다 틱이 낮은게 있으면 레디로 넣는다.(그떄 깨운다)
-	// 현재 실행중인 스레드가 틱이 올라가다가, 블락드의 가장 앞에 잇는것<-가장 틱 낮은것
-	// 어 ? 나보다 낮아졋네 ? 이제 레디로 가라.
+	struct cpu *cpu;	 /* CPU running or queueing this thread. */
+	struct timer_event sleep_timer; /* Wakes the thread from thread_sleep(). */
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;	   /* List element. 레디큐에 들어가는 요소 */
 	int init_priority;		   /* 초기 priority 를 가지고 있어야 함*/
 	struct lock *wait_on_lock; /* 이 락을 얻기 위해 대기하고있는 쓰레드 1개.*/
-	struct list donators;	   /* 나에게 priority를 기부해준 쓰레드 list*/
-	struct list_elem d_elem;   /* donators를 연결해주는 elem */
+	struct rwlock *wait_on_rw; /* 이 rwlock 을 얻기 위해 대기중, 없으면 NULL */
+	struct pheap held_locks;   /* 가지고 있는 hold 들, 기부하는 priority 순 (max-heap) */
+	struct rw_hold rw_holds[RW_HOLD_MAX]; /* 가지고 있는 rwlock 들 */
+	struct pqueue_elem wait_elem; /* 세마포어 waiters 에 들어가는 elem */
+	struct pqueue *waitq;	   /* priority 를 key 로 기다리고 있는 큐, 없으면 NULL */
+	struct pqueue_elem *waitq_elem; /* waitq 안의 elem */
+
+	/* Owned by thread.c, for the MLFQS. */
+	int nice;				   /* Niceness, NICE_MIN to NICE_MAX. */
+	fixed_t recent_cpu;		   /* Recent CPU time received. */
+	struct list_elem allelem;  /* Element in all_list. */
+
+	/* Owned by thread.c, for the CFS. */
+	int64_t vruntime;		   /* Weighted virtual runtime. */
+	struct rb_elem run_node;   /* Element in the CFS run queue. */
+
+	/* Owned by thread.c, for the EDF class. */
+	int64_t dl_runtime;		   /* Budget per period, or 0 if not EDF. */
+	int64_t dl_period;		   /* Period and relative deadline. */
+	int64_t dl_deadline;	   /* Current absolute deadline. */
+	int64_t dl_budget;		   /* Budget left in this period. */
+	uint64_t dl_bw;			   /* Reserved bandwidth. */
+	bool dl_throttled;		   /* Budget used up until dl_deadline? */
+	struct rb_elem dl_node;	   /* Element in the EDF run queue. */
+	struct timer_event dl_timer; /* Replenishes a throttled thread. */
+
+	/* Owned by thread.c, for wakeup latency accounting. */
+	uint64_t wakeup_tsc;	   /* TSC at thread_unblock(), or 0 if running. */
+	unsigned latency_hist[LATENCY_BUCKETS]; /* Wakeup latencies, log2 cycles. */
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4; /* Page map level 4 */
+	struct thread *leader;	   /* Owner of the shared address space, or NULL. */
+	struct user_thread *user_thread; /* Own record in leader's list, or NULL. */
+	struct list user_threads;  /* User threads sharing our address space. */
+	struct lock user_threads_lock; /* Protects user_threads and exiting. */
+	struct condition user_threads_done; /* Signalled as user threads exit. */
+	bool exiting;			   /* Process is exiting: user threads must too. */
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
@@ -133,14 +167,27 @@ struct thread
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
-   Controlled by kernel command-line option "-o mlfqs". */
+   Controlled by kernel command-line option "-mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler.
+   Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
+/* If true, print wakeup latency histograms at power off.
+   Controlled by kernel command-line option "-latency". */
+extern bool thread_latency;
+
+/* Maximum total utilization of EDF threads, in percent.
+   Controlled by kernel command-line option "-edf-bound=PCT". */
+extern int thread_edf_bound;
+
 void thread_init(void);
 void thread_start(void);
 
 void thread_tick(void);
 void thread_print_stats(void);
+void thread_print_latency(void);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
@@ -156,26 +203,27 @@ void thread_exit(void) NO_RETURN;
 void thread_yield(void);
 void thread_sleep(int64_t ticks);
 
+void thread_set_timeslice(int lo, int hi, unsigned ticks);
+unsigned thread_get_timeslice(int priority);
+
 int thread_get_priority(void);
 void thread_set_priority(int);
 int thread_max_priority(struct thread *);
+void thread_update_priority(struct thread *, int priority);
+void test_max_priority(void);
+
+bool thread_set_deadline(int64_t runtime, int64_t period);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
-void thread_wake(int64_t ticks);
 
 void do_iret(struct intr_frame *tf);
 
-// 일어날 시간이 이른 스레드가 앞부분에 위치하도록 정렬할 때 사용할 정렬 함수를 새로 선언한다.
-void sort_thread_ticks();
-
-// 두 스레드의 wakeup_ticks를 비교해서 작으면 true를 반환하는 함수
-bool cmp_thread_ticks(struct list_elem *a_, struct list_elem *b_, void *aux UNUSED);
-bool cmp_dpriority(struct list_elem *a_, struct list_elem *b_, void *aux UNUSED);
-bool cmp_priority(struct list_elem *a_, struct list_elem *b_, void *aux UNUSED);
 void priority_donate(struct lock *lock);
-void remove_with_lock(struct lock *lock);
-void refresh_priority(struct lock *lock);
+void priority_donate_rw(struct rwlock *rw);
+void priority_hold_acquired(struct hold *hold);
+void priority_hold_released(struct hold *hold);
+void refresh_priority(void);
 #endif /* threads/thread.h */
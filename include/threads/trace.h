@@ -0,0 +1,87 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdint.h>
+
+/* Scheduler event tracing.
+
+   Build with `make SCHED_TRACE=1' (after `make clean') to record
+   scheduler events into a ring buffer per CPU.  The buffers are
+   dumped to the console when the kernel powers off, and
+   utils/trace2json turns the dump into Chrome trace-event JSON
+   for chrome://tracing or Perfetto.  Without SCHED_TRACE,
+   trace_event() compiles to nothing.
+
+   Tracing should cost less than TRACE_BUDGET_NS per event.
+   trace_print_cost() measures the actual cost at power off. */
+
+/* Time one trace_event() may take, in nanoseconds. */
+#define TRACE_BUDGET_NS 50
+
+/* Event types. */
+enum trace_type {
+	TRACE_SWITCH = 1,           /* TID switched out; ARG is the next tid. */
+	TRACE_BLOCK,                /* TID blocked. */
+	TRACE_UNBLOCK,              /* TID made ready; ARG is the waker, or -1. */
+	TRACE_DONATE,               /* TID received ARG's priority. */
+	TRACE_TICK                  /* Timer tick while TID ran; ARG is ticks. */
+};
+
+/* One event.  Fixed size, so that the dump is easy to decode. */
+struct trace_record {
+	uint64_t tsc;               /* rdtsc() when the event happened. */
+	int32_t tid;                /* Thread the event is about. */
+	int32_t arg;                /* Event-specific argument. */
+	uint32_t seq;               /* Position in the CPU's event stream. */
+	uint8_t type;               /* enum trace_type. */
+	uint8_t priority;           /* TID's priority at the time. */
+	uint8_t cpu;                /* CPU that recorded the event. */
+	uint8_t status;             /* TID's enum thread_status. */
+};
+
+#ifdef SCHED_TRACE
+#include "threads/cpu.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* Number of records per CPU.  Must be a power of 2. */
+#define TRACE_SIZE 4096
+
+/* A CPU's ring buffer.  Only its own CPU writes to it, and
+   interrupt handlers may interrupt a writer, so a slot is
+   claimed with a single atomic add and no lock is needed. */
+struct trace_buf {
+	uint64_t head;              /* Number of records ever written. */
+	struct trace_record rec[TRACE_SIZE];
+};
+
+void trace_init (void);
+void trace_dump (void);
+void trace_print_cost (void);
+
+/* Records an event of TYPE about thread T, with argument ARG. */
+static inline void
+trace_event (enum trace_type type, const struct thread *t, int32_t arg) {
+	struct cpu *c = cpu_current ();
+	struct trace_buf *b = c->trace;
+	struct trace_record *r;
+	uint64_t seq;
+
+	if (b == NULL)
+		return;
+	seq = __atomic_fetch_add (&b->head, 1, __ATOMIC_RELAXED);
+	r = &b->rec[seq & (TRACE_SIZE - 1)];
+	r->tsc = rdtsc ();
+	r->tid = t->tid;
+	r->arg = arg;
+	r->seq = seq;
+	r->type = type;
+	r->priority = t->priority;
+	r->cpu = c->id;
+	r->status = t->status;
+}
+#else
+#define trace_event(TYPE, T, ARG) ((void) 0)
+#endif
+
+#endif /* threads/trace.h */
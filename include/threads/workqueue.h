@@ -0,0 +1,48 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/timer.h"
+
+/* Workqueues: deferred work that runs in a kernel thread.
+
+   Code that must not sleep, such as an interrupt handler, can
+   queue a struct work to have its function called later by a
+   worker thread, where it may sleep, take locks, and allocate
+   memory.  There is one worker thread per priority below; work
+   runs in the order it was queued for its priority.
+
+   The caller owns each struct work.  It must stay valid while
+   it is queued, and may be queued again once its function has
+   started running, including by the function itself. */
+
+/* Priorities of the worker threads. */
+enum work_priority {
+	WORK_HIGH,                  /* PRI_MAX - 1. */
+	WORK_NORMAL,                /* PRI_DEFAULT. */
+	WORK_LOW,                   /* PRI_MIN. */
+	WORK_PRI_CNT
+};
+
+typedef void work_func (void *aux);
+
+/* A piece of deferred work. */
+struct work {
+	struct list_elem elem;      /* Element in a worker's queue. */
+	work_func *func;            /* Function to call. */
+	void *aux;                  /* Argument for FUNC. */
+	enum work_priority priority; /* Worker that runs it. */
+	bool pending;               /* Queued or delayed, and not yet run? */
+	struct timer_event timer;   /* Delay for queue_delayed_work(). */
+};
+
+void workqueue_init (void);
+
+void work_init (struct work *, work_func *, void *aux, enum work_priority);
+bool queue_work (struct work *);
+bool queue_delayed_work (struct work *, int64_t ticks);
+bool cancel_work (struct work *);
+
+#endif /* threads/workqueue.h */
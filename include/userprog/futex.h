@@ -0,0 +1,18 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include <stdint.h>
+
+/* Results of futex_wait().  lib/user/syscall.h has the same
+   values for user programs. */
+#define FUTEX_WOKEN 0               /* Woken by futex_wake(). */
+#define FUTEX_AGAIN -1              /* *UADDR did not hold EXPECTED. */
+#define FUTEX_TIMEDOUT -2           /* TIMEOUT ticks passed first. */
+#define FUTEX_FAULT -3              /* UADDR is not a mapped user int. */
+
+void futex_init (void);
+int futex_wait (int *uaddr, int expected, int64_t timeout);
+int futex_wake (int *uaddr, int n);
+void futex_wake_all (uint64_t *pml4);
+
+#endif /* userprog/futex.h */
@@ -10,4 +10,21 @@ int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
 
+/* A user thread that shares the address space of its leader,
+   the process's first thread.  The record lives in the leader's
+   user_threads list until the thread has been joined, so it
+   outlives the thread's own struct thread. */
+struct user_thread {
+	tid_t tid;                  /* The thread's identifier. */
+	struct semaphore exited;    /* Upped when the thread exits. */
+	bool joining;               /* Someone is waiting for `exited'? */
+	bool done;                  /* Has the thread exited? */
+	struct list_elem elem;      /* Element in leader->user_threads. */
+};
+
+tid_t process_thread_create (void *entry, void *arg, void *stack);
+int process_thread_join (tid_t);
+void process_exit_if_killed (void);
+struct thread *process_leader (struct thread *);
+
 #endif /* userprog/process.h */
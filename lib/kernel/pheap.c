@@ -0,0 +1,200 @@
+/* Pairing heap.
+
+   See pheap.h for basic information.  The algorithms are the
+   "two-pass" variant from Fredman, Sedgewick, Sleator and
+   Tarjan, "The Pairing Heap: A New Form of Self-Adjusting Heap",
+   Algorithmica 1 (1986). */
+
+#include "pheap.h"
+#include "../debug.h"
+
+static struct pheap_elem *meld (struct pheap *, struct pheap_elem *,
+		struct pheap_elem *);
+static struct pheap_elem *merge_pairs (struct pheap *, struct pheap_elem *);
+static void cut (struct pheap_elem *);
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+pheap_init (struct pheap *h, pheap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+pheap_insert (struct pheap *h, struct pheap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	h->root = meld (h, h->root, e);
+	h->elem_cnt++;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+pheap_remove (struct pheap *h, struct pheap_elem *e) {
+	struct pheap_elem *children;
+
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+	ASSERT (h->elem_cnt > 0);
+
+	children = merge_pairs (h, e->child);
+	if (e == h->root)
+		h->root = children;
+	else {
+		cut (e);
+		h->root = meld (h, h->root, children);
+	}
+	e->child = NULL;
+	h->elem_cnt--;
+}
+
+/* Restores heap order after the key of E, which must be in H,
+   has changed in either direction. */
+void
+pheap_update (struct pheap *h, struct pheap_elem *e) {
+	pheap_remove (h, e);
+	pheap_insert (h, e);
+}
+
+/* Returns the greatest element in H, or a null pointer if H is
+   empty. */
+struct pheap_elem *
+pheap_top (struct pheap *h) {
+	return h->root;
+}
+
+/* Removes and returns the greatest element in H, which must not
+   be empty. */
+struct pheap_elem *
+pheap_pop (struct pheap *h) {
+	struct pheap_elem *top = h->root;
+
+	ASSERT (top != NULL);
+	pheap_remove (h, top);
+	return top;
+}
+
+/* Empties H, calling ACTION on each of its elements, in no
+   particular order.  Takes O(n) time, unlike popping every
+   element.  ACTION may reuse the element it is passed, for
+   example by inserting it into another heap, but must not
+   insert into H or remove from it. */
+void
+pheap_drain (struct pheap *h, pheap_action_func *action, void *aux) {
+	struct pheap_elem *work = h->root;
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+
+	/* WORK is a list of subtrees, linked through `next'.  Each
+	   element visited puts its children in front of the rest. */
+	while (work != NULL) {
+		struct pheap_elem *e = work;
+
+		work = e->next;
+		if (e->child != NULL) {
+			struct pheap_elem *last = e->child;
+			while (last->next != NULL)
+				last = last->next;
+			last->next = work;
+			work = e->child;
+		}
+		e->child = e->next = e->prev = NULL;
+		action (e, aux);
+	}
+}
+
+/* Returns the number of elements in H. */
+size_t
+pheap_size (struct pheap *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+pheap_empty (struct pheap *h) {
+	return h->root == NULL;
+}
+
+/* Melds the heaps rooted at A and B, either of which may be
+   null, by making the lesser root the first child of the other.
+   Returns the new root. */
+static struct pheap_elem *
+meld (struct pheap *h, struct pheap_elem *a, struct pheap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (h->less (a, b, h->aux)) {
+		struct pheap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes A's first child. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Melds the list of sibling heaps starting at FIRST into one
+   heap and returns its root, or a null pointer if FIRST is null.
+   Pairs up the siblings from left to right, then melds the pairs
+   from right to left. */
+static struct pheap_elem *
+merge_pairs (struct pheap *h, struct pheap_elem *first) {
+	struct pheap_elem *pairs = NULL, *root = NULL;
+
+	/* First pass.  PAIRS is a stack of the melded pairs, linked
+	   through their `next' members, so that the second pass visits
+	   them from right to left. */
+	while (first != NULL) {
+		struct pheap_elem *a = first, *b = a->next;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+
+		a = meld (h, a, b);
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Second pass. */
+	while (pairs != NULL) {
+		struct pheap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = meld (h, root, pairs);
+		pairs = next;
+	}
+	return root;
+}
+
+/* Unlinks E, which must not be a root, and its subtree from its
+   parent and siblings. */
+static void
+cut (struct pheap_elem *e) {
+	ASSERT (e->prev != NULL);
+
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+}
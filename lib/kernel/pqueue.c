@@ -0,0 +1,107 @@
+/* Priority wait queue.
+
+   See pqueue.h for basic information. */
+
+#include "pqueue.h"
+#include "../debug.h"
+
+/* Action and auxiliary data passed through pheap_drain(). */
+struct drain_aux {
+	pq_action_func *action;
+	void *aux;
+};
+
+static bool pq_less (const struct pheap_elem *, const struct pheap_elem *,
+		void *aux);
+static void drain_one (struct pheap_elem *, void *da_);
+
+/* Initializes Q as an empty queue. */
+void
+pq_init (struct pqueue *q) {
+	ASSERT (q != NULL);
+
+	pheap_init (&q->heap, pq_less, NULL);
+	q->next_seq = 0;
+}
+
+/* Pushes E into Q with the given KEY. */
+void
+pq_push (struct pqueue *q, struct pqueue_elem *e, int key) {
+	ASSERT (q != NULL);
+	ASSERT (e != NULL);
+
+	e->key = key;
+	e->seq = q->next_seq++;
+	pheap_insert (&q->heap, &e->heap_elem);
+}
+
+/* Returns the element of Q that pq_pop() would remove, or a null
+   pointer if Q is empty. */
+struct pqueue_elem *
+pq_top (struct pqueue *q) {
+	struct pheap_elem *e = pheap_top (&q->heap);
+	return e != NULL ? pheap_entry (e, struct pqueue_elem, heap_elem) : NULL;
+}
+
+/* Removes and returns the element of Q with the greatest key,
+   the earliest pushed among equals.  Q must not be empty. */
+struct pqueue_elem *
+pq_pop (struct pqueue *q) {
+	return pheap_entry (pheap_pop (&q->heap), struct pqueue_elem, heap_elem);
+}
+
+/* Removes E, which must be in Q, from Q. */
+void
+pq_remove (struct pqueue *q, struct pqueue_elem *e) {
+	pheap_remove (&q->heap, &e->heap_elem);
+}
+
+/* Changes the key of E, which must be in Q, to KEY. */
+void
+pq_rekey (struct pqueue *q, struct pqueue_elem *e, int key) {
+	if (e->key == key)
+		return;
+	pheap_remove (&q->heap, &e->heap_elem);
+	e->key = key;
+	pheap_insert (&q->heap, &e->heap_elem);
+}
+
+/* Empties Q in O(n) time, calling ACTION on each element in no
+   particular order.  See pheap_drain() for what ACTION may do. */
+void
+pq_drain (struct pqueue *q, pq_action_func *action, void *aux) {
+	struct drain_aux da = { action, aux };
+	pheap_drain (&q->heap, drain_one, &da);
+}
+
+/* Returns the number of elements in Q. */
+size_t
+pq_size (struct pqueue *q) {
+	return pheap_size (&q->heap);
+}
+
+/* Returns true if Q is empty, false otherwise. */
+bool
+pq_empty (struct pqueue *q) {
+	return pheap_empty (&q->heap);
+}
+
+/* Passes heap element E on to the pq_drain() caller's action. */
+static void
+drain_one (struct pheap_elem *e, void *da_) {
+	struct drain_aux *da = da_;
+	da->action (pheap_entry (e, struct pqueue_elem, heap_elem), da->aux);
+}
+
+/* Orders elements by key, then by reverse push order, so that
+   the earliest pushed of equal keys is the greatest. */
+static bool
+pq_less (const struct pheap_elem *a_, const struct pheap_elem *b_,
+		void *aux UNUSED) {
+	const struct pqueue_elem *a = pheap_entry (a_, struct pqueue_elem, heap_elem);
+	const struct pqueue_elem *b = pheap_entry (b_, struct pqueue_elem, heap_elem);
+
+	if (a->key != b->key)
+		return a->key < b->key;
+	return a->seq > b->seq;
+}
@@ -0,0 +1,298 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.  The algorithms follow
+   [CLRS] chapter 13, adapted to use null pointers instead of a
+   sentinel leaf. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static void rotate_left (struct rbtree *, struct rb_elem *);
+static void rotate_right (struct rbtree *, struct rb_elem *);
+static void replace_child (struct rbtree *, struct rb_elem *old,
+		struct rb_elem *new);
+static void insert_fixup (struct rbtree *, struct rb_elem *);
+static void remove_fixup (struct rbtree *, struct rb_elem *,
+		struct rb_elem *parent);
+
+static inline bool
+is_red (const struct rb_elem *e) {
+	return e != NULL && e->red;
+}
+
+/* Initializes T as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rbtree *t, rb_less_func *less, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (less != NULL);
+
+	t->root = NULL;
+	t->min = NULL;
+	t->elem_cnt = 0;
+	t->less = less;
+	t->aux = aux;
+}
+
+/* Inserts E into T, after any elements equal to it. */
+void
+rb_insert (struct rbtree *t, struct rb_elem *e) {
+	struct rb_elem **link = &t->root;
+	struct rb_elem *parent = NULL;
+	bool leftmost = true;
+
+	ASSERT (t != NULL);
+	ASSERT (e != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (t->less (e, parent, t->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	e->parent = parent;
+	e->left = e->right = NULL;
+	e->red = true;
+	*link = e;
+	if (leftmost)
+		t->min = e;
+	t->elem_cnt++;
+
+	insert_fixup (t, e);
+}
+
+/* Removes E, which must be in T, from T. */
+void
+rb_remove (struct rbtree *t, struct rb_elem *e) {
+	struct rb_elem *child, *parent;
+	bool removed_red;
+
+	ASSERT (t != NULL);
+	ASSERT (e != NULL);
+	ASSERT (t->elem_cnt > 0);
+
+	if (t->min == e)
+		t->min = rb_next (e);
+	t->elem_cnt--;
+
+	if (e->left == NULL || e->right == NULL) {
+		/* E has at most one child, which takes its place. */
+		child = e->left != NULL ? e->left : e->right;
+		parent = e->parent;
+		removed_red = e->red;
+		replace_child (t, e, child);
+	} else {
+		/* E's successor S, which has no left child, takes E's
+		   place and color.  S's right child takes S's place. */
+		struct rb_elem *s = e->right;
+		while (s->left != NULL)
+			s = s->left;
+
+		child = s->right;
+		removed_red = s->red;
+		if (s->parent == e)
+			parent = s;
+		else {
+			parent = s->parent;
+			replace_child (t, s, child);
+			s->right = e->right;
+			s->right->parent = s;
+		}
+		replace_child (t, e, s);
+		s->left = e->left;
+		s->left->parent = s;
+		s->red = e->red;
+	}
+
+	if (!removed_red)
+		remove_fixup (t, child, parent);
+}
+
+/* Returns the smallest element in T, or a null pointer if T is
+   empty. */
+struct rb_elem *
+rb_min (struct rbtree *t) {
+	return t->min;
+}
+
+/* Returns the element that follows E in its tree, or a null
+   pointer if E is the largest element. */
+struct rb_elem *
+rb_next (struct rb_elem *e) {
+	if (e->right != NULL) {
+		e = e->right;
+		while (e->left != NULL)
+			e = e->left;
+		return e;
+	}
+	while (e->parent != NULL && e == e->parent->right)
+		e = e->parent;
+	return e->parent;
+}
+
+/* Returns the number of elements in T. */
+size_t
+rb_size (struct rbtree *t) {
+	return t->elem_cnt;
+}
+
+/* Returns true if T is empty, false otherwise. */
+bool
+rb_empty (struct rbtree *t) {
+	return t->root == NULL;
+}
+
+/* Makes NEW take OLD's place as a child of OLD's parent.  NEW
+   may be null. */
+static void
+replace_child (struct rbtree *t, struct rb_elem *old, struct rb_elem *new) {
+	if (old->parent == NULL)
+		t->root = new;
+	else if (old == old->parent->left)
+		old->parent->left = new;
+	else
+		old->parent->right = new;
+	if (new != NULL)
+		new->parent = old->parent;
+}
+
+/* Rotates the subtree rooted at X to the left, so that X's
+   right child becomes its parent. */
+static void
+rotate_left (struct rbtree *t, struct rb_elem *x) {
+	struct rb_elem *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	replace_child (t, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, so that X's
+   left child becomes its parent. */
+static void
+rotate_right (struct rbtree *t, struct rb_elem *x) {
+	struct rb_elem *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	replace_child (t, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Restores the red-black properties after red element E has
+   been inserted. */
+static void
+insert_fixup (struct rbtree *t, struct rb_elem *e) {
+	struct rb_elem *parent;
+
+	while (is_red (parent = e->parent)) {
+		/* PARENT is red, so it is not the root. */
+		struct rb_elem *grandparent = parent->parent;
+
+		if (parent == grandparent->left) {
+			struct rb_elem *uncle = grandparent->right;
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grandparent->red = true;
+				e = grandparent;
+				continue;
+			}
+			if (e == parent->right) {
+				rotate_left (t, parent);
+				e = parent;
+				parent = e->parent;
+			}
+			parent->red = false;
+			grandparent->red = true;
+			rotate_right (t, grandparent);
+		} else {
+			struct rb_elem *uncle = grandparent->left;
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grandparent->red = true;
+				e = grandparent;
+				continue;
+			}
+			if (e == parent->left) {
+				rotate_right (t, parent);
+				e = parent;
+				parent = e->parent;
+			}
+			parent->red = false;
+			grandparent->red = true;
+			rotate_left (t, grandparent);
+		}
+	}
+	t->root->red = false;
+}
+
+/* Restores the red-black properties after a black element has
+   been removed.  E, which may be null, took its place as a child
+   of PARENT and carries an extra black. */
+static void
+remove_fixup (struct rbtree *t, struct rb_elem *e, struct rb_elem *parent) {
+	while (e != t->root && !is_red (e)) {
+		if (e == parent->left) {
+			struct rb_elem *sibling = parent->right;
+			if (is_red (sibling)) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_left (t, parent);
+				sibling = parent->right;
+			}
+			if (!is_red (sibling->left) && !is_red (sibling->right)) {
+				sibling->red = true;
+				e = parent;
+				parent = e->parent;
+			} else {
+				if (!is_red (sibling->right)) {
+					sibling->left->red = false;
+					sibling->red = true;
+					rotate_right (t, sibling);
+					sibling = parent->right;
+				}
+				sibling->red = parent->red;
+				parent->red = false;
+				sibling->right->red = false;
+				rotate_left (t, parent);
+				e = t->root;
+			}
+		} else {
+			struct rb_elem *sibling = parent->left;
+			if (is_red (sibling)) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_right (t, parent);
+				sibling = parent->left;
+			}
+			if (!is_red (sibling->left) && !is_red (sibling->right)) {
+				sibling->red = true;
+				e = parent;
+				parent = e->parent;
+			} else {
+				if (!is_red (sibling->left)) {
+					sibling->right->red = false;
+					sibling->red = true;
+					rotate_left (t, sibling);
+					sibling = parent->left;
+				}
+				sibling->red = parent->red;
+				parent->red = false;
+				sibling->left->red = false;
+				rotate_right (t, parent);
+				e = t->root;
+			}
+		}
+	}
+	if (e != NULL)
+		e->red = false;
+}
@@ -0,0 +1,100 @@
+#include <synch.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* The mutex follows "Futexes Are Tricky" by Ulrich Drepper: the
+   state tells the unlocker whether anyone may be asleep, so that
+   an unlock only calls futex_wake() when someone might be. */
+
+/* Initializes M as unlocked. */
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+/* Acquires M, sleeping until it is available if necessary. */
+void
+mutex_lock (struct mutex *m) {
+	int c = 0;
+
+	if (__atomic_compare_exchange_n (&m->state, &c, 1, false,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	/* Contended: mark M as having sleepers before sleeping, so
+	   that its holder wakes us. */
+	if (c != 2)
+		c = __atomic_exchange_n (&m->state, 2, __ATOMIC_ACQUIRE);
+	while (c != 0) {
+		futex_wait (&m->state, 2, -1);
+		c = __atomic_exchange_n (&m->state, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+/* Acquires M if it is available without sleeping.  Returns true
+   if successful, false on failure. */
+bool
+mutex_trylock (struct mutex *m) {
+	int c = 0;
+
+	return __atomic_compare_exchange_n (&m->state, &c, 1, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/* Releases M, which the caller must hold, and wakes one thread
+   sleeping on it, if any. */
+void
+mutex_unlock (struct mutex *m) {
+	if (__atomic_fetch_sub (&m->state, 1, __ATOMIC_RELEASE) != 1) {
+		__atomic_store_n (&m->state, 0, __ATOMIC_RELEASE);
+		futex_wake (&m->state, 1);
+	}
+}
+
+/* Initializes C with no waiters. */
+void
+cond_init (struct cond *c) {
+	c->seq = 0;
+	c->waiters = 0;
+}
+
+/* Atomically releases M and waits for C to be signaled, then
+   reacquires M before returning.  M must be held.  Like the
+   kernel's condition variables, a return does not guarantee that
+   the condition holds, so callers should recheck it in a loop. */
+void
+cond_wait (struct cond *c, struct mutex *m) {
+	int seq;
+
+	__atomic_fetch_add (&c->waiters, 1, __ATOMIC_RELAXED);
+	seq = __atomic_load_n (&c->seq, __ATOMIC_ACQUIRE);
+	mutex_unlock (m);
+
+	/* A signal between the unlock and the sleep changes seq, so
+	   futex_wait() returns at once instead of missing it. */
+	futex_wait (&c->seq, seq, -1);
+	__atomic_fetch_sub (&c->waiters, 1, __ATOMIC_RELAXED);
+
+	/* Other waiters may have been woken with us, so reacquire M
+	   in the contended state to make sure they are woken in turn. */
+	while (__atomic_exchange_n (&m->state, 2, __ATOMIC_ACQUIRE) != 0)
+		futex_wait (&m->state, 2, -1);
+}
+
+/* Wakes one thread waiting on C, if any. */
+void
+cond_signal (struct cond *c) {
+	if (__atomic_load_n (&c->waiters, __ATOMIC_RELAXED) > 0) {
+		__atomic_fetch_add (&c->seq, 1, __ATOMIC_RELEASE);
+		futex_wake (&c->seq, 1);
+	}
+}
+
+/* Wakes all threads waiting on C. */
+void
+cond_broadcast (struct cond *c) {
+	if (__atomic_load_n (&c->waiters, __ATOMIC_RELAXED) > 0) {
+		__atomic_fetch_add (&c->seq, 1, __ATOMIC_RELEASE);
+		futex_wake (&c->seq, INT_MAX);
+	}
+}
@@ -194,3 +194,57 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+bool
+set_deadline (long long runtime, long long period) {
+	return syscall2 (SYS_SET_DEADLINE, runtime, period);
+}
+
+int
+futex_wait (int *addr, int expected, long long timeout) {
+	return syscall3 (SYS_FUTEX_WAIT, addr, expected, timeout);
+}
+
+int
+futex_wake (int *addr, int n) {
+	return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+/* What a new user thread runs, stored at the top of its stack. */
+struct thread_start {
+	user_thread_func *func;
+	void *aux;
+};
+
+/* First code run by a new user thread. */
+static void
+thread_start (struct thread_start *start) {
+	start->func (start->aux);
+	thread_exit ();
+}
+
+pid_t
+thread_create (user_thread_func *func, void *aux,
+		void *stack, size_t stack_size) {
+	uintptr_t top = ((uintptr_t) stack + stack_size) & ~(uintptr_t) 15;
+	struct thread_start *start = (struct thread_start *) top - 1;
+
+	start->func = func;
+	start->aux = aux;
+
+	/* Enter thread_start() as if called, with a 16-byte aligned
+	   stack below a return address slot. */
+	return syscall3 (SYS_THREAD_CREATE, thread_start, start,
+			(uintptr_t) start - sizeof (void *));
+}
+
+int
+thread_join (pid_t tid) {
+	return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+void
+thread_exit (void) {
+	syscall0 (SYS_THREAD_EXIT);
+	NOT_REACHED ();
+}
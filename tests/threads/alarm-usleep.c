@@ -0,0 +1,86 @@
+/* Checks that sub-tick sleeps last at least as long as asked,
+   measured with timer_ns(), and that they block instead of
+   spinning: a lower-priority thread must get to run while the
+   main thread sleeps, even though it never would if the main
+   thread stayed runnable.  Also checks that zero and negative
+   sleeps return at once. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEP_CNT 10
+#define SLEEP_US 500
+
+struct spinner
+  {
+    struct semaphore done;      /* Upped when the spinner stops. */
+    volatile bool stop;         /* Tells the spinner to stop. */
+    volatile int64_t spins;     /* Iterations of the spinner. */
+  };
+
+static thread_func spin;
+
+void
+test_alarm_usleep (void)
+{
+  struct spinner s;
+  int64_t before;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&s.done, 0);
+  s.stop = false;
+  s.spins = 0;
+  thread_create ("spinner", PRI_DEFAULT - 1, spin, &s);
+
+  for (i = 0; i < SLEEP_CNT; i++)
+    {
+      uint64_t start = timer_ns ();
+      uint64_t slept;
+
+      before = s.spins;
+      timer_usleep (SLEEP_US);
+      slept = timer_ns () - start;
+
+      if (slept < SLEEP_US * 1000)
+        fail ("sleep %d lasted only %llu ns", i, slept);
+      if (s.spins == before)
+        fail ("spinner did not run during sleep %d", i);
+    }
+  msg ("%d sleeps of %d us each blocked for at least %d us.",
+       SLEEP_CNT, SLEEP_US, SLEEP_US);
+
+  /* Zero and negative sleeps must not block for any tick. */
+  {
+    int64_t start = timer_ticks ();
+
+    timer_usleep (-1);
+    timer_nsleep (-5);
+    timer_msleep (-1);
+    timer_usleep (0);
+    timer_nsleep (0);
+    if (timer_elapsed (start) > 1)
+      fail ("zero or negative sleeps took %lld ticks", timer_elapsed (start));
+  }
+  msg ("Zero and negative sleeps returned at once.");
+
+  s.stop = true;
+  sema_down (&s.done);
+}
+
+static void
+spin (void *s_)
+{
+  struct spinner *s = s_;
+
+  while (!s->stop)
+    s->spins++;
+  sema_up (&s->done);
+}
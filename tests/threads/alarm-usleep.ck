@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-usleep) begin
+(alarm-usleep) 10 sleeps of 500 us each blocked for at least 500 us.
+(alarm-usleep) Zero and negative sleeps returned at once.
+(alarm-usleep) end
+EOF
+pass;
@@ -0,0 +1,96 @@
+/* Measures the throughput of single-page allocation: the number
+   of palloc_get_page() and palloc_free_page() pairs per second,
+   with 1 and with 8 threads allocating at once.
+
+   Each thread repeatedly allocates BATCH pages and frees them
+   again, so that the per-CPU page caches are refilled and
+   drained as well as hit.  With 8 threads, their time slices
+   interleave the batches on the same caches and pool locks.
+   The result is reported in pairs per second, as measured by
+   the TSC. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define PAIR_CNT 65536          /* Pairs per thread. */
+#define BATCH 48                /* Pages held at once per thread. */
+
+struct palloc_bench
+  {
+    struct semaphore done;      /* Upped by the last thread to finish. */
+    int remaining;              /* Threads that have not finished. */
+  };
+
+static thread_func allocator;
+static void run_bench (int thread_cnt);
+
+void
+test_bench_palloc (void)
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  run_bench (1);
+  run_bench (8);
+}
+
+/* Creates THREAD_CNT allocators at our own priority, so that none
+   of them runs until we block, waits for all of them, and reports
+   the throughput. */
+static void
+run_bench (int thread_cnt)
+{
+  struct palloc_bench b;
+  uint64_t start, cycles;
+  int i;
+
+  sema_init (&b.done, 0);
+  b.remaining = thread_cnt;
+  for (i = 0; i < thread_cnt; i++)
+    if (thread_create ("allocator", PRI_DEFAULT, allocator, &b) == TID_ERROR)
+      fail ("could not create thread %d of %d", i, thread_cnt);
+
+  start = rdtsc ();
+  sema_down (&b.done);
+  cycles = rdtsc () - start;
+
+  msg ("%d thread(s): %llu alloc/free pairs per second", thread_cnt,
+       (unsigned long long) ((uint64_t) PAIR_CNT * thread_cnt
+                             * timer_tsc_hz () / cycles));
+}
+
+static void
+allocator (void *b_)
+{
+  struct palloc_bench *b = b_;
+  void *pages[BATCH];
+  enum intr_level old_level;
+  int i, j;
+
+  for (i = 0; i < PAIR_CNT; i += BATCH)
+    {
+      for (j = 0; j < BATCH; j++)
+        {
+          pages[j] = palloc_get_page (0);
+          if (pages[j] == NULL)
+            fail ("out of pages");
+        }
+      for (j = 0; j < BATCH; j++)
+        palloc_free_page (pages[j]);
+    }
+
+  old_level = intr_disable ();
+  if (--b->remaining == 0)
+    sema_up (&b->done);
+  intr_set_level (old_level);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+
+# The timings vary from run to run, so only check that both
+# thread counts produced a result, e.g.:
+#
+# (bench-palloc) 1 thread(s): 21474836 alloc/free pairs per second
+# (bench-palloc) 8 thread(s): 20132659 alloc/free pairs per second
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+for my $thread_cnt (1, 8) {
+    fail "No result for $thread_cnt thread(s).\n"
+      if !grep (/\b$thread_cnt thread\(s\): \d+ alloc\/free pairs/, @output);
+}
+
+pass;
@@ -0,0 +1,134 @@
+/* Measures how read sections scale under a reader-writer lock
+   compared with an exclusive lock, with 1, 8, and 32 reader
+   threads.
+
+   Each read section sleeps for READ_US microseconds while it
+   holds the lock, as a lookup that has to wait for the disk
+   would.  Behind a struct lock the sections run one at a time,
+   so the total time grows with the number of readers.  Behind a
+   struct rwlock they overlap, so it should stay close to that
+   of a single reader.  The average time per round and the most
+   readers seen inside the lock at once are reported. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUND_CNT 4
+#define READ_US 200
+
+struct rw_bench
+  {
+    bool use_rw;                /* rwlock, or plain lock? */
+    struct lock lock;           /* Lock under test, if !use_rw. */
+    struct rwlock rw;           /* Lock under test, if use_rw. */
+    struct semaphore done;      /* Upped by the last reader to finish. */
+    int remaining;              /* Readers that have not finished. */
+    int inside;                 /* Readers inside the lock now. */
+    int max_inside;             /* Most readers inside at once. */
+  };
+
+static thread_func reader;
+static uint64_t run_bench (int thread_cnt, bool use_rw, int *max_inside);
+
+void
+test_bench_rwlock (void)
+{
+  static const int counts[] = {1, 8, 32};
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  for (i = 0; i < sizeof counts / sizeof *counts; i++)
+    {
+      int lock_inside, rw_inside;
+      uint64_t lock_ns = run_bench (counts[i], false, &lock_inside);
+      uint64_t rw_ns = run_bench (counts[i], true, &rw_inside);
+
+      if (lock_inside != 1)
+        fail ("%d readers shared a lock", lock_inside);
+      msg ("%d readers: lock %llu us, rwlock %llu us per round "
+           "(%d readers at once)", counts[i],
+           lock_ns / 1000 / ROUND_CNT, rw_ns / 1000 / ROUND_CNT,
+           rw_inside);
+    }
+}
+
+/* Runs THREAD_CNT readers through ROUND_CNT read sections each,
+   under an rwlock if USE_RW or a lock otherwise, and returns the
+   time until all of them finished, in nanoseconds.  Stores the
+   most readers that were inside at once in *MAX_INSIDE. */
+static uint64_t
+run_bench (int thread_cnt, bool use_rw, int *max_inside)
+{
+  struct rw_bench b;
+  uint64_t start;
+  int i;
+
+  b.use_rw = use_rw;
+  lock_init (&b.lock);
+  rw_init (&b.rw);
+  sema_init (&b.done, 0);
+  b.remaining = thread_cnt;
+  b.inside = b.max_inside = 0;
+
+  /* The readers are at our priority, so none of them runs until
+     we block. */
+  start = timer_ns ();
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "%d", i);
+      if (thread_create (name, PRI_DEFAULT, reader, &b) == TID_ERROR)
+        fail ("could not create thread %d of %d", i, thread_cnt);
+    }
+  sema_down (&b.done);
+
+  *max_inside = b.max_inside;
+  return timer_ns () - start;
+}
+
+static void
+reader (void *b_)
+{
+  struct rw_bench *b = b_;
+  enum intr_level old_level;
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      if (b->use_rw)
+        rw_read_acquire (&b->rw);
+      else
+        lock_acquire (&b->lock);
+
+      old_level = intr_disable ();
+      if (++b->inside > b->max_inside)
+        b->max_inside = b->inside;
+      intr_set_level (old_level);
+
+      timer_usleep (READ_US);
+
+      old_level = intr_disable ();
+      b->inside--;
+      intr_set_level (old_level);
+
+      if (b->use_rw)
+        rw_read_release (&b->rw);
+      else
+        lock_release (&b->lock);
+    }
+
+  old_level = intr_disable ();
+  if (--b->remaining == 0)
+    sema_up (&b->done);
+  intr_set_level (old_level);
+}
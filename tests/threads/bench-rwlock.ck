@@ -0,0 +1,28 @@
+# -*- perl -*-
+
+# The timings vary from run to run, so only check that every
+# reader count produced a result and that all of the readers
+# shared the rwlock, e.g.:
+#
+# (bench-rwlock) 1 readers: lock 231 us, rwlock 229 us per round (1 readers at once)
+# (bench-rwlock) 8 readers: lock 1842 us, rwlock 244 us per round (8 readers at once)
+# (bench-rwlock) 32 readers: lock 7370 us, rwlock 301 us per round (32 readers at once)
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+for my $thread_cnt (1, 8, 32) {
+    fail "No result for $thread_cnt readers.\n"
+      if !grep (/\b$thread_cnt readers: lock \d+ us, rwlock \d+ us/, @output);
+    fail "$thread_cnt readers did not share the rwlock.\n"
+      if !grep (/\b$thread_cnt readers: .*\($thread_cnt readers at once\)/,
+		@output);
+}
+
+pass;
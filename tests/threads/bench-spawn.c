@@ -0,0 +1,81 @@
+/* Measures the throughput of short-lived kernel threads: the
+   cost of creating a thread, letting it run and exit, and
+   waiting for it, with 1, 16, and 64 threads alive at once.
+
+   Each round creates a batch of threads at our priority, so
+   that none of them runs until we block, then waits for all of
+   them to finish.  The threads of one round exit before the
+   next round creates its own, so after the first round most
+   thread pages come from the cache of dead threads, except for
+   batches larger than the cache.  The average cost in TSC
+   cycles per thread is reported for each batch size. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define THREAD_CNT 1024
+
+struct spawn_bench
+  {
+    struct semaphore done;      /* Upped by the last thread in a batch. */
+    int remaining;              /* Threads in the batch still running. */
+  };
+
+static thread_func child;
+static void run_bench (int batch);
+
+void
+test_bench_spawn (void)
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  run_bench (1);
+  run_bench (16);
+  run_bench (64);
+}
+
+/* Creates and joins THREAD_CNT threads, BATCH at a time, and
+   reports the average cost of one thread. */
+static void
+run_bench (int batch)
+{
+  struct spawn_bench b;
+  uint64_t start, cycles;
+  int i, j;
+
+  sema_init (&b.done, 0);
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i += batch)
+    {
+      b.remaining = batch;
+      for (j = 0; j < batch; j++)
+        if (thread_create ("child", PRI_DEFAULT, child, &b) == TID_ERROR)
+          fail ("could not create thread %d", i + j);
+      sema_down (&b.done);
+    }
+  cycles = rdtsc () - start;
+
+  msg ("batches of %d: %llu cycles per create+exit+join",
+       batch, cycles / THREAD_CNT);
+}
+
+static void
+child (void *b_)
+{
+  struct spawn_bench *b = b_;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  if (--b->remaining == 0)
+    sema_up (&b->done);
+  intr_set_level (old_level);
+}
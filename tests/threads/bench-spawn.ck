@@ -0,0 +1,24 @@
+# -*- perl -*-
+
+# The timings vary from run to run, so only check that every
+# batch size produced a result, e.g.:
+#
+# (bench-spawn) batches of 1: 3184 cycles per create+exit+join
+# (bench-spawn) batches of 16: 2411 cycles per create+exit+join
+# (bench-spawn) batches of 64: 2957 cycles per create+exit+join
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+for my $batch (1, 16, 64) {
+    fail "No result for batches of $batch.\n"
+      if !grep (/\bbatches of $batch: \d+ cycles/, @output);
+}
+
+pass;
@@ -0,0 +1,129 @@
+/* Measures the cost of waking a blocked thread and switching to
+   it, with 10, 100, and 1000 other threads ready to run.
+
+   The ready threads sit one priority below ours and just yield
+   until the measurement is over, so they stay in the run queue
+   without running.  We then hand a pair of semaphores back and
+   forth ROUND_CNT times with a partner thread at our priority:
+   each handoff is a sema_up(), whose thread_unblock() queues the
+   partner, followed by a sema_down() that blocks and switches to
+   it.  The average cost in TSC cycles per handoff is reported
+   for each run queue length. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ROUND_CNT 1000
+
+struct wakeup_bench
+  {
+    struct semaphore ping;      /* Upped by us, downed by the partner. */
+    struct semaphore pong;      /* Upped by the partner, downed by us. */
+    struct semaphore done;      /* Upped by the last filler to finish. */
+    int remaining;              /* Fillers that have not finished. */
+    bool stop;                  /* Tells the fillers to finish. */
+  };
+
+static thread_func filler;
+static thread_func partner;
+static void run_bench (int thread_cnt);
+
+void
+test_bench_wakeup (void)
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  run_bench (10);
+  run_bench (100);
+  run_bench (1000);
+}
+
+/* Fills the run queue with THREAD_CNT ready threads, times
+   ROUND_CNT handoffs to and from a partner thread, then lets the
+   fillers finish and reports the average cost of one handoff. */
+static void
+run_bench (int thread_cnt)
+{
+  struct wakeup_bench b;
+  uint64_t start, cycles;
+  int i;
+
+  sema_init (&b.ping, 0);
+  sema_init (&b.pong, 0);
+  sema_init (&b.done, 0);
+  b.remaining = thread_cnt;
+  b.stop = false;
+
+  /* Keep every new thread from running until all exist. */
+  thread_set_priority (PRI_DEFAULT + 1);
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "%d", i);
+      if (thread_create (name, PRI_DEFAULT - 1, filler, &b) == TID_ERROR)
+        fail ("could not create thread %d of %d", i, thread_cnt);
+    }
+  if (thread_create ("partner", PRI_DEFAULT, partner, &b) == TID_ERROR)
+    fail ("could not create partner thread");
+  thread_set_priority (PRI_DEFAULT);
+
+  /* One untimed round lets the partner start up. */
+  sema_up (&b.ping);
+  sema_down (&b.pong);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_up (&b.ping);
+      sema_down (&b.pong);
+    }
+  cycles = rdtsc () - start;
+
+  b.stop = true;
+  sema_down (&b.done);
+
+  /* Each round is two handoffs: ours and the partner's. */
+  msg ("%d ready threads: %llu cycles per wakeup+switch",
+       thread_cnt, cycles / (2 * (uint64_t) ROUND_CNT));
+}
+
+/* Stays ready, without getting to run while the partner and we
+   are busy, until told to stop. */
+static void
+filler (void *b_)
+{
+  struct wakeup_bench *b = b_;
+  enum intr_level old_level;
+
+  while (!b->stop)
+    thread_yield ();
+
+  old_level = intr_disable ();
+  if (--b->remaining == 0)
+    sema_up (&b->done);
+  intr_set_level (old_level);
+}
+
+/* Answers every ping with a pong, for the untimed round and the
+   timed ones. */
+static void
+partner (void *b_)
+{
+  struct wakeup_bench *b = b_;
+  int i;
+
+  for (i = 0; i < ROUND_CNT + 1; i++)
+    {
+      sema_down (&b->ping);
+      sema_up (&b->pong);
+    }
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+
+# The timings vary from run to run, so only check that every
+# run queue length produced a result, e.g.:
+#
+# (bench-wakeup) 10 ready threads: 412 cycles per wakeup+switch
+# (bench-wakeup) 100 ready threads: 418 cycles per wakeup+switch
+# (bench-wakeup) 1000 ready threads: 431 cycles per wakeup+switch
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+for my $thread_cnt (10, 100, 1000) {
+    fail "No result for $thread_cnt ready threads.\n"
+      if !grep (/\b$thread_cnt ready threads: \d+ cycles/, @output);
+}
+
+pass;
@@ -0,0 +1,74 @@
+/* Checks that the completely fair scheduler divides the CPU in
+   proportion to thread weights.
+
+   Two threads spin for 10 seconds, one at nice 0 and the other
+   at nice 5.  Their CFS weights are 1024 and 335, so they should
+   receive about 75% and 25% of the ticks, respectively. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 2
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+    int nice;
+  };
+
+static thread_func load_thread;
+
+void
+test_cfs_nice (void)
+{
+  struct thread_info info[THREAD_CNT];
+  int64_t start_time;
+  int i;
+
+  ASSERT (thread_cfs);
+
+  start_time = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->tick_count = 0;
+      ti->nice = i * 5;
+
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, ti);
+    }
+
+  msg ("Sleeping 12 seconds to let threads run, please wait...");
+  timer_sleep (12 * TIMER_FREQ);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    msg ("Thread %d (nice %d) received %d ticks.",
+         i, info[i].nice, info[i].tick_count);
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 1 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 10 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_nice (ti->nice);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,32 @@
+# -*- perl -*-
+
+# The two threads share 10 seconds (1000 ticks) of CPU time in
+# the ratio of their weights, 1024:335, i.e. about 753 and 247
+# ticks.  Allow some slack for the main thread and for wakeup
+# placement.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+my (@ticks);
+for my $i (0, 1) {
+    my ($line) = grep (/Thread $i \(nice \d+\) received \d+ ticks/, @output);
+    fail "No result for thread $i.\n" if !defined $line;
+    ($ticks[$i]) = $line =~ /received (\d+) ticks/;
+}
+
+my ($total) = $ticks[0] + $ticks[1];
+fail "Threads received only $total ticks in total.\n" if $total < 900;
+
+my ($share) = $ticks[0] / $total;
+fail sprintf ("Nice 0 thread received %.1f%% of the CPU, "
+	      . "expected about 75%%.\n", $share * 100)
+  if $share < 0.70 || $share > 0.80;
+
+pass;
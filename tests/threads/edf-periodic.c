@@ -0,0 +1,130 @@
+/* Runs three periodic EDF tasks with a combined utilization of
+   60%, alongside a CPU-bound thread at PRI_MAX, and checks that
+   every job finishes before its deadline.  Also checks that a
+   reservation that would push the total utilization over the
+   admission bound is refused. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define TASK_CNT 3
+#define RUN_TICKS 300
+
+struct edf_task
+  {
+    int64_t runtime;            /* Reserved ticks per period. */
+    int64_t period;             /* Period and relative deadline. */
+    int64_t start;              /* Release time of the first job. */
+    bool admitted;              /* Did thread_set_deadline() succeed? */
+    int jobs;                   /* Jobs completed. */
+    int misses;                 /* Jobs that missed their deadline. */
+    struct semaphore *done;     /* Upped when all jobs are finished. */
+  };
+
+static thread_func edf_task, hog;
+
+void
+test_edf_periodic (void)
+{
+  struct edf_task tasks[TASK_CNT] =
+    {
+      {2, 10, 0, false, 0, 0, NULL},
+      {3, 15, 0, false, 0, 0, NULL},
+      {5, 25, 0, false, 0, 0, NULL},
+    };
+  struct semaphore done;
+  int64_t start;
+  int i;
+
+  ASSERT (thread_edf_bound >= 60);
+
+  sema_init (&done, 0);
+  start = timer_ticks () + 10;
+  for (i = 0; i < TASK_CNT; i++)
+    {
+      char name[16];
+
+      tasks[i].start = start;
+      tasks[i].done = &done;
+      snprintf (name, sizeof name, "edf %d", i);
+      thread_create (name, PRI_MAX, edf_task, &tasks[i]);
+    }
+
+  /* Each task preempted us to make its reservation.  The three
+     hold 60% between them, so another 50% must not fit under
+     the bound. */
+  if (thread_set_deadline (5, 10))
+    fail ("reservation over the admission bound was accepted");
+  msg ("Reservation over the admission bound was refused.");
+
+  /* A full-bandwidth reservation with a huge period must not
+     overflow into a tiny one that slips under the bound. */
+  if (thread_set_deadline (1LL << 44, 1LL << 44))
+    fail ("reservation with a 2^44-tick period was accepted");
+  msg ("Reservation with an overlong period was refused.");
+
+  /* The hog keeps us off the CPU until the tasks are done. */
+  thread_create ("hog", PRI_MAX, hog, &start);
+  for (i = 0; i < TASK_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < TASK_CNT; i++)
+    msg ("Task %d (%lld/%lld): %s, %d jobs, %d deadline misses.",
+         i, tasks[i].runtime, tasks[i].period,
+         tasks[i].admitted ? "admitted" : "refused",
+         tasks[i].jobs, tasks[i].misses);
+}
+
+/* Releases a job every period, runs it for just under the
+   reserved runtime, and records whether it finished in time. */
+static void
+edf_task (void *task_)
+{
+  struct edf_task *task = task_;
+  int64_t release;
+
+  task->admitted = thread_set_deadline (task->runtime, task->period);
+
+  for (release = task->start; release + task->period <= task->start + RUN_TICKS;
+       release += task->period)
+    {
+      int64_t last_time, finish;
+      int ticks;
+
+      if (release > timer_ticks ())
+        timer_sleep (release - timer_ticks ());
+
+      /* Spin until we have seen RUNTIME - 1 tick boundaries. */
+      last_time = timer_ticks ();
+      for (ticks = 0; ticks < task->runtime - 1; )
+        {
+          int64_t cur_time = timer_ticks ();
+          if (cur_time != last_time)
+            ticks++;
+          last_time = cur_time;
+        }
+
+      finish = timer_ticks ();
+      task->jobs++;
+      if (finish > release + task->period)
+        task->misses++;
+    }
+
+  thread_set_deadline (0, 0);
+  sema_up (task->done);
+}
+
+/* Keeps the CPU busy at the highest ordinary priority for as
+   long as the tasks run, starting from the time *START_. */
+static void
+hog (void *start_)
+{
+  int64_t end = *(int64_t *) start_ + RUN_TICKS;
+
+  while (timer_ticks () < end)
+    continue;
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-periodic) begin
+(edf-periodic) Reservation over the admission bound was refused.
+(edf-periodic) Reservation with an overlong period was refused.
+(edf-periodic) Task 0 (2/10): admitted, 30 jobs, 0 deadline misses.
+(edf-periodic) Task 1 (3/15): admitted, 20 jobs, 0 deadline misses.
+(edf-periodic) Task 2 (5/25): admitted, 12 jobs, 0 deadline misses.
+(edf-periodic) end
+EOF
+pass;
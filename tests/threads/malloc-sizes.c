@@ -0,0 +1,77 @@
+/* Allocates blocks of sizes on both sides of the malloc() size
+   class boundaries, fills each with its own byte, and checks that
+   none of them overlap.  Then frees every other block, allocates
+   those again, and checks again, so that blocks are reused from
+   partially full arenas. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+#define BLOCK_CNT 40            /* Blocks per size. */
+
+static const size_t sizes[] =
+  {
+    1, 16, 17, 24, 25, 33, 64, 65, 80, 81, 100, 129,
+    500, 1024, 1025, 1500, 1792, 1793, 2100, 5000,
+  };
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+static char *blocks[SIZE_CNT][BLOCK_CNT];
+
+static void fill (size_t s, size_t i);
+static void check_all (void);
+
+void
+test_malloc_sizes (void)
+{
+  size_t s, i;
+
+  for (s = 0; s < SIZE_CNT; s++)
+    for (i = 0; i < BLOCK_CNT; i++)
+      fill (s, i);
+  check_all ();
+  msg ("allocated %zu blocks", SIZE_CNT * BLOCK_CNT);
+
+  for (s = 0; s < SIZE_CNT; s++)
+    for (i = 1; i < BLOCK_CNT; i += 2)
+      free (blocks[s][i]);
+  for (s = 0; s < SIZE_CNT; s++)
+    for (i = 1; i < BLOCK_CNT; i += 2)
+      fill (s, i);
+  check_all ();
+  msg ("reallocated every other block");
+
+  for (s = 0; s < SIZE_CNT; s++)
+    for (i = 0; i < BLOCK_CNT; i++)
+      free (blocks[s][i]);
+  msg ("freed all blocks");
+}
+
+/* Allocates block I of size index S and fills it with a byte
+   that identifies it. */
+static void
+fill (size_t s, size_t i)
+{
+  char *p = malloc (sizes[s]);
+
+  if (p == NULL)
+    fail ("malloc(%zu) failed", sizes[s]);
+  memset (p, s * BLOCK_CNT + i, sizes[s]);
+  blocks[s][i] = p;
+}
+
+/* Fails if any block's contents were overwritten. */
+static void
+check_all (void)
+{
+  size_t s, i, j;
+
+  for (s = 0; s < SIZE_CNT; s++)
+    for (i = 0; i < BLOCK_CNT; i++)
+      for (j = 0; j < sizes[s]; j++)
+        if (blocks[s][i][j] != (char) (s * BLOCK_CNT + i))
+          fail ("%zu-byte block %zu overwritten at offset %zu",
+                sizes[s], i, j);
+}
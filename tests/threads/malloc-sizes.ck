@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-sizes) begin
+(malloc-sizes) allocated 800 blocks
+(malloc-sizes) reallocated every other block
+(malloc-sizes) freed all blocks
+(malloc-sizes) end
+EOF
+pass;
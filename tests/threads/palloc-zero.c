@@ -0,0 +1,74 @@
+/* Checks that PAL_ZERO pages come from the stock of pre-zeroed
+   pages while it lasts, are zeroed on demand once it runs out,
+   and that the low priority worker refills it while we sleep.
+   Every page must read as zeros either way. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define SMALL_CNT 16            /* Fewer pages than the stock holds. */
+#define LARGE_CNT 128           /* More pages than the stock holds. */
+
+static void *pages[LARGE_CNT];
+
+static void get_zeroed (size_t cnt, long long *hits, long long *misses);
+
+void
+test_palloc_zero (void)
+{
+  long long hits, misses;
+
+  /* Let the worker fill the stock. */
+  timer_sleep (10);
+  get_zeroed (SMALL_CNT, &hits, &misses);
+  if (hits != SMALL_CNT)
+    fail ("%lld of %d pages were pre-zeroed", hits, SMALL_CNT);
+  msg ("%d pages served pre-zeroed", SMALL_CNT);
+
+  get_zeroed (LARGE_CNT, &hits, &misses);
+  if (misses == 0)
+    fail ("all %d pages were pre-zeroed", LARGE_CNT);
+  msg ("fell back to zeroing on demand");
+
+  timer_sleep (10);
+  get_zeroed (SMALL_CNT, &hits, &misses);
+  if (hits != SMALL_CNT)
+    fail ("%lld of %d pages were pre-zeroed after refill", hits, SMALL_CNT);
+  msg ("stock refilled");
+}
+
+/* Allocates CNT zeroed pages, checks that they read as zeros,
+   dirties and frees them, and stores how many were pre-zeroed
+   and zeroed on demand in *HITS and *MISSES. */
+static void
+get_zeroed (size_t cnt, long long *hits, long long *misses)
+{
+  long long hits0, misses0;
+  size_t i, j;
+
+  palloc_zero_stats (0, &hits0, &misses0);
+  for (i = 0; i < cnt; i++)
+    {
+      pages[i] = palloc_get_page (PAL_ZERO);
+      if (pages[i] == NULL)
+        fail ("out of pages");
+    }
+  palloc_zero_stats (0, hits, misses);
+  *hits -= hits0;
+  *misses -= misses0;
+
+  for (i = 0; i < cnt; i++)
+    {
+      uint64_t *p = pages[i];
+      for (j = 0; j < PGSIZE / sizeof *p; j++)
+        if (p[j] != 0)
+          fail ("page %zu not zeroed at offset %zu", i, j * sizeof *p);
+      p[0] = -1;
+      palloc_free_page (pages[i]);
+    }
+}
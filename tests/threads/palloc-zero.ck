@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-zero) begin
+(palloc-zero) 16 pages served pre-zeroed
+(palloc-zero) fell back to zeroing on demand
+(palloc-zero) stock refilled
+(palloc-zero) end
+EOF
+pass;
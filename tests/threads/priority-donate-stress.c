@@ -0,0 +1,277 @@
+/* Runs 64 threads, at 8 different priorities above the main
+   thread's, that contend for a set of 4 nested locks.  Thread I
+   starts at lock I % 4 and acquires every lock from there up to
+   the last, yielding after each acquire, so that threads holding
+   lower locks wait on threads holding higher ones and donations
+   travel along chains of holders.
+
+   Checks that the counter protected by the innermost lock ends
+   up correct, and that no thread keeps a donated priority after
+   releasing all of its locks.  Reports the average cost in TSC
+   cycles of lock_acquire() and lock_release(), including the
+   time spent waiting for a contended lock.
+
+   Then builds a chain of holders longer than the kernel follows
+   when donating, ending at a thread that holds two locks, and
+   checks that the donation that stops short of it still leaves
+   its held locks in order: when it recomputes its priority, it
+   must see the highest waiter at the far end of the chain. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define THREAD_CNT 64
+#define LOCK_CNT 4
+#define ITER_CNT 20
+
+/* Waiters in the deep chain.  Donation follows at most 8 links,
+   so the last waiter's donation stops one link short of the
+   thread at the end. */
+#define CHAIN_CNT 9
+
+struct stress
+  {
+    struct lock locks[LOCK_CNT];
+    struct semaphore done;      /* Upped by the last thread to finish. */
+    int remaining;              /* Threads that have not finished. */
+    int counter;                /* Protected by locks[LOCK_CNT - 1]. */
+
+    /* Totals over all threads, updated with interrupts off. */
+    uint64_t acquire_cycles, release_cycles;
+    uint64_t acquire_max;
+    int acquire_cnt, release_cnt;
+    int bad_priority_cnt;
+  };
+
+struct worker
+  {
+    struct stress *s;
+    int id;
+  };
+
+struct chain
+  {
+    struct lock locks[CHAIN_CNT];   /* Waiter I holds I, wants I - 1. */
+    struct lock side;               /* Also held by the end thread. */
+    struct semaphore go;            /* Lets the end thread continue. */
+    struct semaphore done;          /* Upped by each finished thread. */
+    int end_priority;               /* Recomputed by the end thread. */
+    int bad_priority_cnt;
+  };
+
+struct link
+  {
+    struct chain *c;
+    int id;
+  };
+
+static thread_func worker;
+static thread_func chain_end;
+static thread_func chain_side;
+static thread_func chain_link;
+static void deep_chain (void);
+
+void
+test_priority_donate_stress (void)
+{
+  static struct worker workers[THREAD_CNT];
+  struct stress s;
+  int expected, i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  for (i = 0; i < LOCK_CNT; i++)
+    lock_init (&s.locks[i]);
+  sema_init (&s.done, 0);
+  s.remaining = THREAD_CNT;
+  s.counter = 0;
+  s.acquire_cycles = s.release_cycles = s.acquire_max = 0;
+  s.acquire_cnt = s.release_cnt = 0;
+  s.bad_priority_cnt = 0;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+
+      workers[i].s = &s;
+      workers[i].id = i;
+      snprintf (name, sizeof name, "stress %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i / LOCK_CNT % 8,
+                     worker, &workers[i]);
+    }
+  sema_down (&s.done);
+
+  expected = THREAD_CNT * ITER_CNT;
+  if (s.counter != expected)
+    fail ("counter is %d, expected %d", s.counter, expected);
+  if (s.bad_priority_cnt != 0)
+    fail ("%d threads kept a donated priority", s.bad_priority_cnt);
+  if (thread_get_priority () != PRI_DEFAULT)
+    fail ("main thread has priority %d", thread_get_priority ());
+  msg ("%d threads, %d nested locks: counter is %d.",
+       THREAD_CNT, LOCK_CNT, s.counter);
+  msg ("acquire: %llu cycles average, %llu max; release: %llu cycles average",
+       s.acquire_cycles / s.acquire_cnt, s.acquire_max,
+       s.release_cycles / s.release_cnt);
+
+  deep_chain ();
+}
+
+/* The end thread runs at PRI_DEFAULT + 1 and holds the first
+   chain lock and the side lock.  A side waiter at PRI_DEFAULT + 5
+   waits on the side lock, then chain links 1 to CHAIN_CNT - 1 at
+   PRI_DEFAULT + 1 and link CHAIN_CNT at PRI_DEFAULT + 10 queue up
+   behind it.  The last link's donation raises links 1 to
+   CHAIN_CNT - 1 but not the end thread, so the end thread's holds
+   have changed order without its priority changing. */
+static void
+deep_chain (void)
+{
+  static struct link links[CHAIN_CNT + 1];
+  struct chain c;
+  int i;
+
+  for (i = 0; i < CHAIN_CNT; i++)
+    lock_init (&c.locks[i]);
+  lock_init (&c.side);
+  sema_init (&c.go, 0);
+  sema_init (&c.done, 0);
+  c.end_priority = 0;
+  c.bad_priority_cnt = 0;
+
+  for (i = 0; i <= CHAIN_CNT; i++)
+    {
+      links[i].c = &c;
+      links[i].id = i;
+    }
+  thread_create ("chain end", PRI_DEFAULT + 1, chain_end, &links[0]);
+  thread_create ("chain side", PRI_DEFAULT + 5, chain_side, &c);
+  for (i = 1; i <= CHAIN_CNT; i++)
+    {
+      char name[16];
+
+      snprintf (name, sizeof name, "chain %d", i);
+      thread_create (name, i < CHAIN_CNT ? PRI_DEFAULT + 1 : PRI_DEFAULT + 10,
+                     chain_link, &links[i]);
+    }
+
+  sema_up (&c.go);
+  for (i = 0; i < CHAIN_CNT + 2; i++)
+    sema_down (&c.done);
+
+  if (c.end_priority != PRI_DEFAULT + 10)
+    fail ("end of a chain of %d waiters recomputed priority %d, "
+          "expected %d", CHAIN_CNT, c.end_priority, PRI_DEFAULT + 10);
+  if (c.bad_priority_cnt != 0)
+    fail ("%d chain threads kept a donated priority", c.bad_priority_cnt);
+  msg ("Chain of %d waiters: end holder recomputed priority %d.",
+       CHAIN_CNT, c.end_priority);
+}
+
+static void
+worker (void *w_)
+{
+  struct worker *w = w_;
+  struct stress *s = w->s;
+  int first = w->id % LOCK_CNT;
+  uint64_t acquire_cycles = 0, release_cycles = 0, acquire_max = 0;
+  enum intr_level old_level;
+  int i, k;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      for (k = first; k < LOCK_CNT; k++)
+        {
+          uint64_t start = rdtsc (), cycles;
+
+          lock_acquire (&s->locks[k]);
+          cycles = rdtsc () - start;
+          acquire_cycles += cycles;
+          if (cycles > acquire_max)
+            acquire_max = cycles;
+          thread_yield ();
+        }
+
+      s->counter++;
+
+      for (k = LOCK_CNT - 1; k >= first; k--)
+        {
+          uint64_t start = rdtsc ();
+
+          lock_release (&s->locks[k]);
+          release_cycles += rdtsc () - start;
+        }
+    }
+
+  old_level = intr_disable ();
+  if (thread_get_priority () != PRI_DEFAULT + 1 + w->id / LOCK_CNT % 8)
+    s->bad_priority_cnt++;
+  s->acquire_cycles += acquire_cycles;
+  s->release_cycles += release_cycles;
+  if (acquire_max > s->acquire_max)
+    s->acquire_max = acquire_max;
+  s->acquire_cnt += ITER_CNT * (LOCK_CNT - first);
+  s->release_cnt += ITER_CNT * (LOCK_CNT - first);
+  if (--s->remaining == 0)
+    sema_up (&s->done);
+  intr_set_level (old_level);
+}
+
+static void
+chain_end (void *l_)
+{
+  struct link *l = l_;
+  struct chain *c = l->c;
+
+  lock_acquire (&c->side);
+  lock_acquire (&c->locks[0]);
+  sema_down (&c->go);
+
+  /* Setting the same priority recomputes the donated one from
+     the held locks. */
+  thread_set_priority (PRI_DEFAULT + 1);
+  c->end_priority = thread_get_priority ();
+
+  lock_release (&c->locks[0]);
+  lock_release (&c->side);
+  if (thread_get_priority () != PRI_DEFAULT + 1)
+    c->bad_priority_cnt++;
+  sema_up (&c->done);
+}
+
+static void
+chain_side (void *c_)
+{
+  struct chain *c = c_;
+
+  lock_acquire (&c->side);
+  lock_release (&c->side);
+  sema_up (&c->done);
+}
+
+static void
+chain_link (void *l_)
+{
+  struct link *l = l_;
+  struct chain *c = l->c;
+  int priority = l->id < CHAIN_CNT ? PRI_DEFAULT + 1 : PRI_DEFAULT + 10;
+
+  if (l->id < CHAIN_CNT)
+    lock_acquire (&c->locks[l->id]);
+  lock_acquire (&c->locks[l->id - 1]);
+  lock_release (&c->locks[l->id - 1]);
+  if (l->id < CHAIN_CNT)
+    lock_release (&c->locks[l->id]);
+  if (thread_get_priority () != priority)
+    c->bad_priority_cnt++;
+  sema_up (&c->done);
+}
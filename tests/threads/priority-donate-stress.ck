@@ -0,0 +1,28 @@
+# -*- perl -*-
+
+# The timings vary from run to run, so only check that they were
+# reported, e.g.:
+#
+# (priority-donate-stress) 64 threads, 4 nested locks: counter is 1280.
+# (priority-donate-stress) acquire: 2874 cycles average, 180233 max; release: 1021 cycles average
+# (priority-donate-stress) Chain of 9 waiters: end holder recomputed priority 41.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+fail "Wrong or missing counter.\n"
+  if !grep (/64 threads, 4 nested locks: counter is 1280\.$/, @output);
+fail "No latency report.\n"
+  if !grep (/acquire: \d+ cycles average, \d+ max; release: \d+ cycles average/,
+	    @output);
+fail "Wrong or missing deep chain result.\n"
+  if !grep (/Chain of 9 waiters: end holder recomputed priority 41\.$/,
+	    @output);
+
+pass;
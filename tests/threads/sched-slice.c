@@ -0,0 +1,119 @@
+/* Checks that thread_set_timeslice() changes how often threads
+   of one priority take turns on the CPU.
+
+   Two CPU-bound threads at the same priority spin for SPIN_TICKS
+   timer ticks and count how many times the CPU passes from one to
+   the other.  With 1-tick slices that should happen about every
+   tick, with 8-tick slices only about every 8 ticks.  The wakeup
+   latency histograms are printed at the end. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SPIN_TICKS 40
+#define SPIN_PRI (PRI_DEFAULT + 1)
+
+struct slice_test
+  {
+    int64_t end;                /* Timer tick to stop spinning at. */
+    int last;                   /* Spinner that ran last, or -1. */
+    int switches;               /* Times the CPU changed spinner. */
+    int remaining;              /* Spinners that have not finished. */
+    struct semaphore done;      /* Upped by the last spinner. */
+  };
+
+struct spinner
+  {
+    struct slice_test *test;
+    int id;
+  };
+
+static thread_func spinner;
+static int run_spinners (unsigned slice);
+
+void
+test_sched_slice (void)
+{
+  unsigned old_slice = thread_get_timeslice (SPIN_PRI);
+  int short_switches, long_switches;
+
+  /* This test does not work with the MLFQS or the CFS. */
+  ASSERT (!thread_mlfqs);
+  ASSERT (!thread_cfs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  short_switches = run_spinners (1);
+  long_switches = run_spinners (8);
+  thread_set_timeslice (SPIN_PRI, SPIN_PRI, old_slice);
+
+  if (short_switches <= 2 * long_switches)
+    fail ("%d switches with 1-tick slices, %d with 8-tick slices",
+          short_switches, long_switches);
+  msg ("1-tick slices switched more often than 8-tick slices.");
+
+  thread_print_latency ();
+}
+
+/* Runs two spinners at SPIN_PRI with time slices of SLICE ticks
+   and returns the number of times the CPU passed between them. */
+static int
+run_spinners (unsigned slice)
+{
+  struct slice_test t;
+  struct spinner s[2];
+  int i;
+
+  thread_set_timeslice (SPIN_PRI, SPIN_PRI, slice);
+  t.last = -1;
+  t.switches = 0;
+  t.remaining = 2;
+  sema_init (&t.done, 0);
+
+  /* Keep the spinners from running until both exist. */
+  thread_set_priority (SPIN_PRI + 1);
+  for (i = 0; i < 2; i++)
+    {
+      char name[16];
+
+      s[i].test = &t;
+      s[i].id = i;
+      snprintf (name, sizeof name, "sliced %d", i);
+      thread_create (name, SPIN_PRI, spinner, &s[i]);
+    }
+  t.end = timer_ticks () + SPIN_TICKS;
+  thread_set_priority (PRI_DEFAULT);
+
+  sema_down (&t.done);
+  return t.switches;
+}
+
+static void
+spinner (void *s_)
+{
+  struct spinner *s = s_;
+  struct slice_test *t = s->test;
+  enum intr_level old_level;
+
+  while (timer_ticks () < t->end)
+    {
+      old_level = intr_disable ();
+      if (t->last != s->id)
+        {
+          t->last = s->id;
+          t->switches++;
+        }
+      intr_set_level (old_level);
+    }
+
+  old_level = intr_disable ();
+  if (--t->remaining == 0)
+    sema_up (&t->done);
+  intr_set_level (old_level);
+}
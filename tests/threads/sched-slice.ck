@@ -0,0 +1,28 @@
+# -*- perl -*-
+
+# The wakeup latency histograms vary from run to run, so only
+# check that the slices took effect and that the histograms were
+# printed, e.g.:
+#
+# (sched-slice) 1-tick slices switched more often than 8-tick slices.
+# Wakeup latency, log2 TSC cycles: count
+#   all                  11:3 12:40 13:2
+#   main (1)             12:4
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+fail "Time slices did not take effect.\n"
+  if !grep (/1-tick slices switched more often than 8-tick slices/, @output);
+fail "Wakeup latency histograms were not printed.\n"
+  if !grep (/^Wakeup latency, log2 TSC cycles/, @output);
+fail "No wakeup latency histogram for all threads.\n"
+  if !grep (/^\s+all\s+(\d+:\d+\s*)+$/, @output);
+
+pass;
@@ -0,0 +1,115 @@
+/* Checks the slab allocator's bookkeeping on a cache of its own.
+   Fills SLAB_CNT slabs and checks that they move from the
+   partial list to the full list; frees one object and checks
+   that its slab is partial again; frees everything and checks
+   that only SLAB_EMPTY_MAX empty slabs stay, the rest having
+   gone back to the page allocator.  Throughout, the constructor
+   must run exactly once per object of every slab created, and
+   objects must keep their constructed state while free. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/slab.h"
+
+#define SLAB_CNT 3              /* Slabs to fill. */
+#define OBJ_MAGIC 0x5eed5eed    /* Set by the constructor. */
+
+struct obj
+  {
+    unsigned magic;             /* OBJ_MAGIC once constructed. */
+    char data[196];
+  };
+
+static size_t ctor_calls;
+static struct obj *objs[SLAB_CNT * (4096 / sizeof (struct obj))];
+
+static void obj_ctor (void *);
+static void alloc_all (struct kmem_cache *, size_t cnt);
+static void check_lists (struct kmem_cache *, size_t partial, size_t full,
+                         size_t empty);
+
+void
+test_slab_cache (void)
+{
+  struct kmem_cache *c = kmem_cache_create ("test", sizeof (struct obj), 0,
+                                            obj_ctor);
+  size_t per_slab = c->objs_per_slab;
+  size_t cnt = SLAB_CNT * per_slab;
+  size_t i;
+
+  ASSERT (cnt <= sizeof objs / sizeof *objs);
+
+  /* The first object makes a partial slab. */
+  alloc_all (c, 1);
+  check_lists (c, 1, 0, 0);
+  kmem_cache_free (c, objs[0]);
+  check_lists (c, 0, 0, 1);
+  msg ("partial slab became empty");
+
+  alloc_all (c, cnt);
+  check_lists (c, 0, SLAB_CNT, 0);
+  if (ctor_calls != cnt)
+    fail ("constructor ran %zu times for %zu objects", ctor_calls, cnt);
+  msg ("filled %d full slabs", SLAB_CNT);
+
+  kmem_cache_free (c, objs[0]);
+  check_lists (c, 1, SLAB_CNT - 1, 0);
+  objs[0] = kmem_cache_alloc (c);
+  check_lists (c, 0, SLAB_CNT, 0);
+  msg ("freed object made its slab partial, then full again");
+
+  for (i = 0; i < cnt; i++)
+    kmem_cache_free (c, objs[i]);
+  check_lists (c, 0, 0, SLAB_EMPTY_MAX);
+  if (c->slab_cnt != SLAB_EMPTY_MAX || c->in_use != 0)
+    fail ("%zu slabs and %zu objects left", c->slab_cnt, c->in_use);
+  msg ("%d empty slabs went back to palloc", SLAB_CNT - SLAB_EMPTY_MAX);
+
+  /* Objects of the kept slab are reused without construction. */
+  alloc_all (c, cnt);
+  if (ctor_calls != cnt + (SLAB_CNT - SLAB_EMPTY_MAX) * per_slab)
+    fail ("constructor ran %zu times in all", ctor_calls);
+  msg ("constructor ran once per object");
+
+  for (i = 0; i < cnt; i++)
+    kmem_cache_free (c, objs[i]);
+}
+
+static void
+obj_ctor (void *obj_)
+{
+  struct obj *obj = obj_;
+
+  obj->magic = OBJ_MAGIC;
+  ctor_calls++;
+}
+
+/* Allocates CNT objects from C into objs[], checking that each
+   one is constructed. */
+static void
+alloc_all (struct kmem_cache *c, size_t cnt)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      objs[i] = kmem_cache_alloc (c);
+      if (objs[i] == NULL)
+        fail ("out of memory");
+      if (objs[i]->magic != OBJ_MAGIC)
+        fail ("object %zu not constructed", i);
+    }
+}
+
+/* Fails unless C has PARTIAL, FULL and EMPTY slabs on its
+   lists. */
+static void
+check_lists (struct kmem_cache *c, size_t partial, size_t full, size_t empty)
+{
+  if (list_size (&c->partial) != partial || list_size (&c->full) != full
+      || list_size (&c->empty) != empty || c->empty_cnt != empty)
+    fail ("expected %zu partial, %zu full and %zu empty slabs, "
+          "found %zu, %zu and %zu", partial, full, empty,
+          list_size (&c->partial), list_size (&c->full),
+          list_size (&c->empty));
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) partial slab became empty
+(slab-cache) filled 3 full slabs
+(slab-cache) freed object made its slab partial, then full again
+(slab-cache) 2 empty slabs went back to palloc
+(slab-cache) constructor ran once per object
+(slab-cache) end
+EOF
+pass;
@@ -29,6 +29,28 @@ static const struct test tests[] =
         {"priority-preempt", test_priority_preempt},
         {"priority-sema", test_priority_sema},
         {"priority-condvar", test_priority_condvar},
+        {"bench-wakeup", test_bench_wakeup},
+        {"cfs-nice", test_cfs_nice},
+        {"edf-periodic", test_edf_periodic},
+        {"alarm-usleep", test_alarm_usleep},
+        {"priority-donate-stress", test_priority_donate_stress},
+        {"bench-rwlock", test_bench_rwlock},
+        {"bench-spawn", test_bench_spawn},
+        {"workqueue", test_workqueue},
+        {"sched-slice", test_sched_slice},
+        {"bench-palloc", test_bench_palloc},
+        {"malloc-sizes", test_malloc_sizes},
+        {"palloc-zero", test_palloc_zero},
+        {"slab-cache", test_slab_cache},
+        {"mlfqs-load-1", test_mlfqs_load_1},
+        {"mlfqs-load-60", test_mlfqs_load_60},
+        {"mlfqs-load-avg", test_mlfqs_load_avg},
+        {"mlfqs-recent-1", test_mlfqs_recent_1},
+        {"mlfqs-fair-2", test_mlfqs_fair_2},
+        {"mlfqs-fair-20", test_mlfqs_fair_20},
+        {"mlfqs-nice-2", test_mlfqs_nice_2},
+        {"mlfqs-nice-10", test_mlfqs_nice_10},
+        {"mlfqs-block", test_mlfqs_block},
 
 };
 
@@ -23,6 +23,19 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_bench_wakeup;
+extern test_func test_cfs_nice;
+extern test_func test_edf_periodic;
+extern test_func test_alarm_usleep;
+extern test_func test_priority_donate_stress;
+extern test_func test_bench_rwlock;
+extern test_func test_bench_spawn;
+extern test_func test_workqueue;
+extern test_func test_sched_slice;
+extern test_func test_bench_palloc;
+extern test_func test_malloc_sizes;
+extern test_func test_palloc_zero;
+extern test_func test_slab_cache;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -0,0 +1,73 @@
+/* Checks the workqueue API: queued work runs once in its worker
+   thread even if it is queued twice, delayed work waits for at
+   least its delay, and cancelled work does not run. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+struct work_test
+  {
+    struct semaphore done;      /* Upped each time the work runs. */
+    int runs;                   /* Number of times the work ran. */
+    char thread[16];            /* Thread it last ran in. */
+  };
+
+static work_func record;
+
+void
+test_workqueue (void)
+{
+  struct work_test t;
+  struct work w;
+  int64_t start;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&t.done, 0);
+  t.runs = 0;
+
+  /* The low-priority worker cannot run until we block, so the
+     work is still pending when we queue it again. */
+  work_init (&w, record, &t, WORK_LOW);
+  if (!queue_work (&w))
+    fail ("queue_work failed on idle work");
+  if (queue_work (&w))
+    fail ("queue_work succeeded on pending work");
+  sema_down (&t.done);
+  timer_sleep (1);
+  msg ("Work queued twice ran %d time(s), in %s.", t.runs, t.thread);
+
+  /* Delayed work. */
+  start = timer_ticks ();
+  queue_delayed_work (&w, 5);
+  sema_down (&t.done);
+  if (timer_elapsed (start) < 5)
+    fail ("work delayed by 5 ticks ran after %lld", timer_elapsed (start));
+  msg ("Work delayed by 5 ticks ran after at least 5.");
+
+  /* Cancelled work. */
+  queue_delayed_work (&w, 10);
+  if (!cancel_work (&w))
+    fail ("cancel_work failed on pending work");
+  if (cancel_work (&w))
+    fail ("cancel_work succeeded on idle work");
+  timer_sleep (20);
+  msg ("Work ran %d time(s) in all.", t.runs);
+}
+
+static void
+record (void *t_)
+{
+  struct work_test *t = t_;
+
+  t->runs++;
+  strlcpy (t->thread, thread_name (), sizeof t->thread);
+  sema_up (&t->done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Work queued twice ran 1 time(s), in kworker/low.
+(workqueue) Work delayed by 5 ticks ran after at least 5.
+(workqueue) Work ran 2 time(s) in all.
+(workqueue) end
+EOF
+pass;
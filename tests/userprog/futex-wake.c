@@ -0,0 +1,48 @@
+/* Puts the main thread to sleep in futex_wait() and has a second
+   thread wake it with futex_wake(), several times over.  The
+   waker keeps calling futex_wake() until it reports having woken
+   a thread, so each round is a real sleep and wakeup, not a
+   value check that returns at once. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ROUND_CNT 5
+#define STACK_SIZE 4096
+
+static char stack[STACK_SIZE];
+static int word;
+static int wakeups;
+
+static void
+waker (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      while (futex_wake (&word, 1) == 0)
+        continue;
+      wakeups++;
+    }
+}
+
+void
+test_main (void) 
+{
+  pid_t tid;
+  int i;
+
+  tid = thread_create (waker, NULL, stack, STACK_SIZE);
+  if (tid == PID_ERROR)
+    fail ("thread_create failed");
+  for (i = 0; i < ROUND_CNT; i++)
+    if (futex_wait (&word, 0, -1) != FUTEX_WOKEN)
+      fail ("futex_wait %d did not sleep until woken", i);
+  CHECK (thread_join (tid) == 0, "join waker");
+
+  if (wakeups != ROUND_CNT)
+    fail ("%d wakeups, should be %d", wakeups, ROUND_CNT);
+  msg ("woken %d times", wakeups);
+}
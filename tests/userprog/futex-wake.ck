@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-wake) begin
+(futex-wake) join waker
+(futex-wake) woken 5 times
+(futex-wake) end
+futex-wake: exit(0)
+EOF
+pass;
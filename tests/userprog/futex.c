@@ -0,0 +1,33 @@
+/* Checks the futex system calls and the user-level mutex and
+   condition variable built on them, from a single thread: a
+   wait on a changed value or with a timeout returns without a
+   wakeup, and uncontended locking works. */
+
+#include <syscall.h>
+#include <synch.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word = 1;
+
+void
+test_main (void) 
+{
+  struct mutex m = MUTEX_INITIALIZER;
+  struct cond c = COND_INITIALIZER;
+
+  CHECK (futex_wait (&word, 0, -1) == FUTEX_AGAIN,
+         "futex_wait on a changed value");
+  CHECK (futex_wait (&word, 1, 2) == FUTEX_TIMEDOUT,
+         "futex_wait with a 2-tick timeout");
+  CHECK (futex_wake (&word, 1) == 0, "futex_wake with no sleepers");
+  CHECK (futex_wait (NULL, 0, -1) == FUTEX_FAULT,
+         "futex_wait on a null pointer");
+
+  mutex_lock (&m);
+  CHECK (!mutex_trylock (&m), "mutex_trylock on a held mutex");
+  cond_signal (&c);
+  mutex_unlock (&m);
+  CHECK (mutex_trylock (&m), "mutex_trylock on a free mutex");
+  mutex_unlock (&m);
+}
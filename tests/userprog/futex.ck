@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex) begin
+(futex) futex_wait on a changed value
+(futex) futex_wait with a 2-tick timeout
+(futex) futex_wake with no sleepers
+(futex) futex_wait on a null pointer
+(futex) mutex_trylock on a held mutex
+(futex) mutex_trylock on a free mutex
+(futex) end
+futex: exit(0)
+EOF
+pass;
@@ -0,0 +1,50 @@
+/* Starts several user threads that share a counter protected by
+   a user-level mutex, joins them, and checks the total.  Also
+   checks that a thread cannot be joined twice. */
+
+#include <syscall.h>
+#include <synch.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ROUND_CNT 1000
+#define STACK_SIZE 4096
+
+static char stacks[THREAD_CNT][STACK_SIZE];
+static struct mutex lock = MUTEX_INITIALIZER;
+static int counter;
+
+static void
+adder (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      mutex_lock (&lock);
+      counter++;
+      mutex_unlock (&lock);
+    }
+}
+
+void
+test_main (void) 
+{
+  pid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      tids[i] = thread_create (adder, NULL, stacks[i], STACK_SIZE);
+      if (tids[i] == PID_ERROR)
+        fail ("thread_create %d failed", i);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (thread_join (tids[i]) == 0, "join thread %d", i);
+  CHECK (thread_join (tids[0]) == -1, "join thread 0 again");
+
+  if (counter != THREAD_CNT * ROUND_CNT)
+    fail ("counter is %d, should be %d", counter, THREAD_CNT * ROUND_CNT);
+  msg ("counter is %d", counter);
+}
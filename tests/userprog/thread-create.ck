@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-create) begin
+(thread-create) join thread 0
+(thread-create) join thread 1
+(thread-create) join thread 2
+(thread-create) join thread 3
+(thread-create) join thread 0 again
+(thread-create) counter is 4000
+(thread-create) end
+thread-create: exit(0)
+EOF
+pass;
@@ -0,0 +1,253 @@
+#include "threads/apic.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/io.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Local APIC and I/O APIC.  See [IA32-v3a] chapter 10 "Advanced
+   Programmable Interrupt Controller (APIC)" and the 82093AA I/O
+   APIC datasheet.
+
+   External interrupts keep the vectors that the 8259A PICs give
+   them, 0x20 + IRQ, so drivers do not need to know which
+   controller is in use.  The I/O APIC routes ISA IRQs to the
+   boot CPU as drivers register them, and the local APIC timer
+   raises vector 0x20 in place of the 8254 on IRQ 0. */
+
+bool apic_enabled;
+
+/* CPUID.1 feature bits. */
+#define CPUID_EDX_APIC (1u << 9)
+#define CPUID_ECX_X2APIC (1u << 21)
+#define CPUID_ECX_TSC_DEADLINE (1u << 24)
+
+/* MSRs. */
+#define MSR_APIC_BASE 0x1b
+#define APIC_BASE_X2APIC (1u << 10)     /* x2APIC mode enable. */
+#define APIC_BASE_ENABLE (1u << 11)     /* APIC global enable. */
+#define MSR_X2APIC_BASE 0x800           /* MSR of register 0 in x2APIC mode. */
+#define MSR_TSC_DEADLINE 0x6e0
+
+/* Local APIC register offsets, in xAPIC MMIO space.  In x2APIC
+   mode, register OFS is MSR MSR_X2APIC_BASE + OFS / 16. */
+#define LAPIC_TPR 0x080                 /* Task priority. */
+#define LAPIC_EOI 0x0b0                 /* End of interrupt. */
+#define LAPIC_SVR 0x0f0                 /* Spurious interrupt vector. */
+#define LAPIC_LVT_TIMER 0x320           /* LVT timer. */
+#define LAPIC_LVT_LINT0 0x350           /* LVT local interrupt 0. */
+#define LAPIC_LVT_ERROR 0x370           /* LVT error. */
+#define LAPIC_TIMER_INIT 0x380          /* Timer initial count. */
+#define LAPIC_TIMER_CUR 0x390           /* Timer current count. */
+#define LAPIC_TIMER_DIV 0x3e0           /* Timer divide configuration. */
+
+#define SVR_ENABLE 0x100                /* APIC software enable. */
+#define LVT_MASKED 0x10000              /* Interrupt masked. */
+#define LVT_TIMER_TSC_DEADLINE 0x40000  /* Timer mode: TSC-deadline. */
+#define TIMER_DIV_16 0x3                /* Divide the bus clock by 16. */
+
+/* Vector for spurious local APIC interrupts, which need no EOI.
+   Its low 4 bits must be set on older processors. */
+#define SPURIOUS_VEC 0xff
+
+/* I/O APIC, at its conventional physical address. */
+#define IOAPIC_PHYS 0xfec00000
+#define IOAPIC_REGSEL 0x00              /* Register select. */
+#define IOAPIC_WIN 0x10                 /* Window to selected register. */
+#define IOAPIC_VER 0x01                 /* Version and max redirection. */
+#define IOAPIC_REDTBL 0x10              /* Redirection table, 2 per pin. */
+#define IOAPIC_MASKED 0x10000           /* Redirection entry masked. */
+
+static bool x2apic;                     /* Registers are MSRs? */
+static bool tsc_deadline;               /* Timer in TSC-deadline mode? */
+static volatile uint32_t *lapic_mmio;   /* xAPIC register window. */
+static volatile uint32_t *ioapic_mmio;  /* I/O APIC register window. */
+static uint32_t lapic_id;               /* Boot CPU's APIC ID. */
+
+/* State of the last lapic_timer_set(). */
+static uint64_t timer_start;            /* TSC when set, in TSC-deadline mode. */
+static uint32_t timer_count;            /* Initial count, in one-shot mode. */
+
+static intr_handler_func spurious_interrupt;
+
+/* Maps the page of device registers at physical address PA into
+   the kernel address space, uncached, and returns its address. */
+static volatile uint32_t *
+map_mmio (uint64_t pa) {
+	uint64_t *pte = pml4e_walk (base_pml4, (uint64_t) ptov (pa), 1);
+	if (pte == NULL)
+		PANIC ("cannot map APIC registers at %#llx", pa);
+	*pte = pa | PTE_P | PTE_W | PTE_PCD | PTE_PWT;
+	return ptov (pa);
+}
+
+static uint32_t
+lapic_read (unsigned reg) {
+	if (x2apic)
+		return read_msr (MSR_X2APIC_BASE + reg / 16);
+	return lapic_mmio[reg / 4];
+}
+
+static void
+lapic_write (unsigned reg, uint32_t value) {
+	if (x2apic)
+		write_msr (MSR_X2APIC_BASE + reg / 16, value);
+	else
+		lapic_mmio[reg / 4] = value;
+}
+
+static uint32_t
+ioapic_read (unsigned reg) {
+	ioapic_mmio[IOAPIC_REGSEL / 4] = reg;
+	return ioapic_mmio[IOAPIC_WIN / 4];
+}
+
+static void
+ioapic_write (unsigned reg, uint32_t value) {
+	ioapic_mmio[IOAPIC_REGSEL / 4] = reg;
+	ioapic_mmio[IOAPIC_WIN / 4] = value;
+}
+
+/* If apic_enabled, switches interrupt delivery from the 8259A
+   PICs, which intr_init() has already remapped, to the APICs.
+   Uses x2APIC mode when the CPU supports it, since its EOI is a
+   single MSR write instead of an uncached memory access. */
+void
+apic_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+	uint64_t base;
+	int pin, max_pin;
+
+	if (!apic_enabled)
+		return;
+
+	cpuid (1, &eax, &ebx, &ecx, &edx);
+	if (!(edx & CPUID_EDX_APIC)) {
+		printf ("No local APIC, using 8259A PIC.\n");
+		apic_enabled = false;
+		return;
+	}
+	x2apic = (ecx & CPUID_ECX_X2APIC) != 0;
+	tsc_deadline = (ecx & CPUID_ECX_TSC_DEADLINE) != 0;
+
+	base = read_msr (MSR_APIC_BASE) | APIC_BASE_ENABLE;
+	if (x2apic)
+		base |= APIC_BASE_X2APIC;
+	write_msr (MSR_APIC_BASE, base);
+	if (x2apic)
+		lapic_id = read_msr (MSR_X2APIC_BASE + 0x020 / 16);
+	else {
+		lapic_mmio = map_mmio (base & ~(uint64_t) PGMASK);
+		lapic_id = lapic_mmio[0x020 / 4] >> 24;
+	}
+	ioapic_mmio = map_mmio (IOAPIC_PHYS);
+
+	/* Mask both 8259As.  They can still raise spurious IRQ 7 or
+	   15, but those arrive on 0x27 or 0x2f and are ignored. */
+	outb (0x21, 0xff);
+	outb (0xa1, 0xff);
+
+	/* Mask every I/O APIC pin until its IRQ is registered. */
+	max_pin = (ioapic_read (IOAPIC_VER) >> 16) & 0xff;
+	for (pin = 0; pin <= max_pin; pin++)
+		ioapic_write (IOAPIC_REDTBL + 2 * pin, IOAPIC_MASKED);
+
+	intr_register_int (SPURIOUS_VEC, 0, INTR_OFF, spurious_interrupt,
+			"APIC Spurious");
+	lapic_write (LAPIC_TPR, 0);
+	lapic_write (LAPIC_LVT_LINT0, LVT_MASKED);
+	lapic_write (LAPIC_LVT_ERROR, LVT_MASKED);
+	lapic_write (LAPIC_SVR, SVR_ENABLE | SPURIOUS_VEC);
+
+	printf ("APIC: %s mode, timer in %s mode.\n",
+			x2apic ? "x2APIC" : "xAPIC",
+			tsc_deadline ? "TSC-deadline" : "one-shot");
+}
+
+/* Signals end of interrupt to the local APIC. */
+void
+apic_eoi (void) {
+	if (x2apic)
+		write_msr (MSR_X2APIC_BASE + LAPIC_EOI / 16, 0);
+	else
+		lapic_mmio[LAPIC_EOI / 4] = 0;
+}
+
+/* Routes ISA IRQ to interrupt vector VEC on the boot CPU, edge
+   triggered and active high.  Assumes that the I/O APIC's pins
+   match the ISA IRQs, as they do for every IRQ but 0, which the
+   local APIC timer replaces. */
+void
+ioapic_route (int irq, uint8_t vec) {
+	ASSERT (apic_enabled);
+	ASSERT (irq > 0 && irq < 16);
+
+	ioapic_write (IOAPIC_REDTBL + 2 * irq + 1, lapic_id << 24);
+	ioapic_write (IOAPIC_REDTBL + 2 * irq, vec);
+}
+
+/* Sets up the local APIC timer to raise VEC when it expires.
+   Prefers TSC-deadline mode, which counts TSC cycles, over
+   one-shot mode, which counts bus clocks divided by 16. */
+void
+lapic_timer_init (uint8_t vec) {
+	ASSERT (apic_enabled);
+
+	if (tsc_deadline)
+		lapic_write (LAPIC_LVT_TIMER, LVT_TIMER_TSC_DEADLINE | vec);
+	else {
+		lapic_write (LAPIC_TIMER_DIV, TIMER_DIV_16);
+		lapic_write (LAPIC_LVT_TIMER, vec);
+	}
+}
+
+/* Returns true if the timer counts TSC cycles. */
+bool
+lapic_timer_tsc_deadline (void) {
+	return tsc_deadline;
+}
+
+/* Arms the timer to interrupt once, after COUNTS timer clocks.
+   Replaces any earlier setting.  COUNTS is capped at
+   lapic_timer_max(). */
+void
+lapic_timer_set (uint64_t counts) {
+	if (counts == 0)
+		counts = 1;
+	if (counts > lapic_timer_max ())
+		counts = lapic_timer_max ();
+
+	if (tsc_deadline) {
+		timer_start = rdtsc ();
+		write_msr (MSR_TSC_DEADLINE, timer_start + counts);
+	} else {
+		timer_count = counts;
+		lapic_write (LAPIC_TIMER_INIT, counts);
+	}
+}
+
+/* Returns the number of timer clocks since the last
+   lapic_timer_set().  In one-shot mode, the count stops when the
+   timer expires. */
+uint64_t
+lapic_timer_elapsed (void) {
+	if (tsc_deadline)
+		return rdtsc () - timer_start;
+	return timer_count - lapic_read (LAPIC_TIMER_CUR);
+}
+
+/* Returns the longest interval that lapic_timer_set() accepts. */
+uint64_t
+lapic_timer_max (void) {
+	return tsc_deadline ? UINT64_MAX / 2 : UINT32_MAX;
+}
+
+/* Spurious interrupts are not real interrupts and are not
+   acknowledged. */
+static void
+spurious_interrupt (struct intr_frame *f UNUSED) {
+}
@@ -0,0 +1,38 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include "intrinsic.h"
+
+/* Per-CPU data, indexed by CPU id. */
+struct cpu cpus[CPU_MAX];
+
+/* Number of CPUs that are online.  Always 1: the application
+   processors are not started, so the per-CPU areas give the boot
+   CPU's scheduler state and statistics a home, not SMP.  Starting
+   the APs first needs every critical section that relies on
+   intr_disable() alone moved to real locks. */
+int cpu_cnt;
+
+#define MSR_GS_BASE 0xc0000101        /* GS base while in the kernel. */
+#define MSR_KERNEL_GS_BASE 0xc0000102 /* GS base swapped in by swapgs. */
+
+/* Sets up the per-CPU area for the bootstrap processor and
+   points its GS base at it.
+
+   The kernel runs with GS base pointing to the current CPU's
+   struct cpu.  Kernel entry and exit paths from and to user mode
+   execute `swapgs', so that user code runs with
+   MSR_KERNEL_GS_BASE holding the kernel's value, and anything a
+   user program does to %gs cannot affect the kernel.  Nothing in
+   the kernel may load %gs, which would reset the base. */
+void
+cpu_init (void) {
+	struct cpu *c = &cpus[0];
+
+	ASSERT (cpu_cnt == 0);
+
+	c->self = c;
+	c->id = 0;
+	write_msr (MSR_GS_BASE, (uint64_t) c);
+	write_msr (MSR_KERNEL_GS_BASE, 0);
+	cpu_cnt = 1;
+}
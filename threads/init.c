@@ -1,5 +1,6 @@
 #include "threads/init.h"
 #include <console.h>
+#include <ctype.h>
 #include <debug.h>
 #include <limits.h>
 #include <random.h>
@@ -13,6 +14,7 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/apic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -20,7 +22,10 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -56,6 +61,7 @@ static void paging_init (uint64_t mem_end);
 
 static char **read_command_line (void);
 static char **parse_options (char **argv);
+static void parse_slice (char *value);
 static void run_actions (char **argv);
 static void usage (void);
 
@@ -85,7 +91,11 @@ main (void) {
 	/* Initialize memory system. */
 	mem_end = palloc_init ();
 	malloc_init ();
+	slab_init ();
 	paging_init (mem_end);
+#ifdef SCHED_TRACE
+	trace_init ();
+#endif
 
 #ifdef USERPROG
 	tss_init ();
@@ -104,8 +114,9 @@ main (void) {
 
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	workqueue_init ();
+	palloc_start_zeroing ();
 	serial_init_queue ();
-	timer_calibrate ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -201,6 +212,46 @@ read_command_line (void) {
 	return argv;
 }
 
+/* Parses VALUE, the argument to the "-slice" option, which has
+   the form LO[-HI]:TICKS, and sets the time slice of priorities
+   LO through HI to TICKS. */
+static void
+parse_slice (char *value) {
+	char *save_ptr, *range, *ticks, *hi;
+	int lo_pri, hi_pri;
+
+	range = value != NULL ? strtok_r (value, ":", &save_ptr) : NULL;
+	ticks = range != NULL ? strtok_r (NULL, "", &save_ptr) : NULL;
+	if (ticks == NULL || atoi (ticks) <= 0)
+		PANIC ("bad -slice value (use -h for help)");
+
+	lo_pri = atoi (strtok_r (range, "-", &save_ptr));
+	hi = strtok_r (NULL, "", &save_ptr);
+	hi_pri = hi != NULL ? atoi (hi) : lo_pri;
+	if (lo_pri < PRI_MIN || lo_pri > hi_pri || hi_pri > PRI_MAX)
+		PANIC ("bad -slice priority range `%s'", range);
+
+	thread_set_timeslice (lo_pri, hi_pri, atoi (ticks));
+}
+
+/* Parses VALUE, the argument to the "-edf-bound" option, which
+   must be a whole percentage from 0 to 100, and sets the EDF
+   bandwidth bound to it. */
+static void
+parse_edf_bound (const char *value) {
+	const char *p;
+
+	if (value == NULL || *value == '\0' || strlen (value) > 3)
+		PANIC ("bad -edf-bound value (use -h for help)");
+	for (p = value; *p != '\0'; p++)
+		if (!isdigit (*p))
+			PANIC ("bad -edf-bound value `%s'", value);
+	if (atoi (value) > 100)
+		PANIC ("bad -edf-bound value `%s'", value);
+
+	thread_edf_bound = atoi (value);
+}
+
 /* Parses options in ARGV[]
    and returns the first non-option argument. */
 static char **
@@ -222,6 +273,18 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-cfs"))
+			thread_cfs = true;
+		else if (!strcmp (name, "-edf-bound"))
+			parse_edf_bound (value);
+		else if (!strcmp (name, "-slice"))
+			parse_slice (value);
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-apic"))
+			apic_enabled = true;
+		else if (!strcmp (name, "-latency"))
+			thread_latency = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -327,6 +390,12 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Use completely fair scheduler.\n"
+			"  -edf-bound=PCT     Limit EDF threads to PCT%% of the CPU.\n"
+			"  -slice=LO[-HI]:N   Give priorities LO to HI time slices of N ticks.\n"
+			"  -tickless          Stop the timer tick while idle.\n"
+			"  -apic              Use the local APIC and IOAPIC, not the 8259A and 8254.\n"
+			"  -latency           Print wakeup latency histograms at power off.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -342,6 +411,9 @@ power_off (void) {
 #ifdef FILESYS
 	filesys_done ();
 #endif
+#ifdef SCHED_TRACE
+	trace_dump ();
+#endif
 
 	print_stats ();
 
@@ -355,6 +427,15 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	if (thread_latency)
+		thread_print_latency ();
+	intr_print_stats ();
+#ifdef SCHED_TRACE
+	trace_print_cost ();
+#endif
+	palloc_print_stats ();
+	malloc_print_stats ();
+	kmem_cache_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
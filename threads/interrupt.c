@@ -3,9 +3,11 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "threads/apic.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/softirq.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
@@ -13,6 +15,7 @@
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/gdt.h"
+#include "userprog/process.h"
 #endif
 
 /* Number of x86_64 interrupts. */
@@ -103,6 +106,13 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Time spent in each external interrupt's handler, with
+   interrupts off, in TSC cycles.  Softirqs are not included;
+   see softirq.c for theirs. */
+static long long hardirq_cnt[16];
+static uint64_t hardirq_cycles[16];
+static uint64_t hardirq_max_cycles[16];
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -131,11 +141,14 @@ intr_set_level (enum intr_level level) {
 	return level == INTR_ON ? intr_enable () : intr_disable ();
 }
 
-/* Enables interrupts and returns the previous interrupt status. */
+/* Enables interrupts and returns the previous interrupt status.
+   Softirqs run with interrupts on, so only an external
+   interrupt's handler itself may not call this; the paths that
+   sleep check intr_context() on their own. */
 enum intr_level
 intr_enable (void) {
 	enum intr_level old_level = intr_get_level ();
-	ASSERT (!intr_context ());
+	ASSERT (!in_external_intr);
 
 	/* Enable interrupts by setting the interrupt flag.
 
@@ -201,6 +214,9 @@ intr_init (void) {
 	intr_names[17] = "#AC Alignment Check Exception";
 	intr_names[18] = "#MC Machine-Check Exception";
 	intr_names[19] = "#XF SIMD Floating-Point Exception";
+
+	/* With -apic, hand over from the PICs to the APICs. */
+	apic_init ();
 }
 
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
@@ -229,6 +245,10 @@ intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 		const char *name) {
 	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
+
+	/* IRQ 0 is replaced by the local APIC timer. */
+	if (apic_enabled && vec_no != 0x20)
+		ioapic_route (vec_no - 0x20, vec_no);
 }
 
 /* Registers internal interrupt VEC_NO to invoke HANDLER, which
@@ -252,17 +272,18 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
+/* Returns true during processing of an external interrupt,
+   including the softirqs that run as it returns, and false at
+   all other times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	return in_external_intr || softirq_active ();
 }
 
 /* During processing of an external interrupt, directs the
    interrupt handler to yield to a new process just before
-   returning from the interrupt.  May not be called at any other
-   time. */
+   returning from the interrupt, after any softirqs.  May not be
+   called at any other time. */
 void
 intr_yield_on_return (void) {
 	ASSERT (intr_context ());
@@ -332,6 +353,7 @@ void
 intr_handler (struct intr_frame *frame) {
 	bool external;
 	intr_handler_func *handler;
+	uint64_t start = 0;
 
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
@@ -340,10 +362,17 @@ intr_handler (struct intr_frame *frame) {
 	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
-		ASSERT (!intr_context ());
+		ASSERT (!in_external_intr);
 
 		in_external_intr = true;
-		yield_on_return = false;
+		/* An interrupt that arrives during a softirq must not drop
+		   a yield that the softirq has already asked for. */
+		if (!softirq_active ())
+			yield_on_return = false;
+		start = rdtsc ();
+
+		/* Catch up on ticks skipped by a tickless idle. */
+		timer_irq_enter ();
 	}
 
 	/* Invoke the interrupt's handler. */
@@ -366,14 +395,46 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (intr_context ());
 
-		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		uint64_t cycles = rdtsc () - start;
+		int irq = frame->vec_no - 0x20;
+		hardirq_cnt[irq]++;
+		hardirq_cycles[irq] += cycles;
+		if (cycles > hardirq_max_cycles[irq])
+			hardirq_max_cycles[irq] = cycles;
 
-		if (yield_on_return)
+		in_external_intr = false;
+		if (apic_enabled)
+			apic_eoi ();
+		else
+			pic_end_of_interrupt (frame->vec_no);
+
+		/* Run the bottom halves, unless this interrupt arrived
+		   during them, in which case they are still running. */
+		softirq_run ();
+		if (yield_on_return && !softirq_active ())
 			thread_yield ();
+#ifdef USERPROG
+		/* A user thread whose process is exiting leaves on its way
+		   back to user mode. */
+		if (frame->cs == SEL_UCSEG)
+			process_exit_if_killed ();
+#endif
 	}
 }
 
+/* Prints the time spent in each external interrupt handler and
+   in the softirqs. */
+void
+intr_print_stats (void) {
+	for (int irq = 0; irq < 16; irq++)
+		if (hardirq_cnt[irq] > 0)
+			printf ("Hard IRQ %#04x (%s): %lld interrupts, avg %llu cycles, "
+					"max %llu cycles\n", irq + 0x20, intr_names[irq + 0x20],
+					hardirq_cnt[irq], hardirq_cycles[irq] / hardirq_cnt[irq],
+					hardirq_max_cycles[irq]);
+	softirq_print_stats ();
+}
+
 /* Dumps interrupt frame F to the console, for debugging. */
 void
 intr_dump_frame (const struct intr_frame *f) {
@@ -11,22 +11,26 @@
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
-
-   When we free a block, we add it to its descriptor's free list.
-   But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
+   The size of each request, in bytes, is rounded up to the next
+   size class and assigned to the "descriptor" that manages
+   blocks of that size.  Between powers of two the classes step by
+   a quarter of the lower power (64, 80, 96, 112, 128, 160, ...),
+   so a request wastes at most about a fifth of its block instead
+   of nearly half.
+
+   Free blocks are kept on a list inside their own arena, a page
+   of memory obtained from the page allocator.  The descriptor
+   keeps the arenas that have both free and in-use blocks on
+   ARENA_BINS lists, binned by how full they are, and satisfies a
+   request from the fullest one.  New allocations thus pack into
+   a few busy arenas while the rest drain.  If no arena has a free
+   block, a new page is obtained (if none is available, malloc()
+   returns a null pointer), divided into blocks, and one of them
+   is returned.
+
+   When we free a block, we add it to its arena's free list.  If
+   the arena now has no in-use blocks, we give it back to the page
+   allocator right away.
 
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
@@ -34,12 +38,23 @@
    with the page allocator and sticking the allocation size at
    the beginning of the allocated block's arena header. */
 
+/* Number of partial-arena lists per descriptor.  Bin 0 holds the
+   fullest arenas. */
+#define ARENA_BINS 4
+
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
-	struct list free_list;      /* List of free blocks. */
+	struct list partial[ARENA_BINS]; /* Arenas with free blocks. */
+	size_t arena_cnt;           /* Arenas currently held. */
 	struct lock lock;           /* Lock. */
+
+	/* Statistics, for malloc_print_stats(). */
+	unsigned long long allocs;     /* Blocks handed out. */
+	unsigned long long requested;  /* Bytes asked for by those. */
+	unsigned long long pow2_bytes; /* Bytes they took in 2^n classes. */
+	unsigned long long released;   /* Arenas given back to palloc. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -50,6 +65,8 @@ struct arena {
 	unsigned magic;             /* Always set to ARENA_MAGIC. */
 	struct desc *desc;          /* Owning descriptor, null for big block. */
 	size_t free_cnt;            /* Free blocks; pages in big block. */
+	struct list free_list;      /* Free blocks in this arena. */
+	struct list_elem elem;      /* Element in a desc's partial list. */
 };
 
 /* Free block. */
@@ -58,25 +75,105 @@ struct block {
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[32];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
+/* Returns the size class that follows BLOCK_SIZE: a quarter of
+   the largest power of two not above BLOCK_SIZE further on, but
+   never less than 8 bytes so that blocks stay aligned. */
+static size_t
+next_block_size (size_t block_size) {
+	size_t pow2 = 16;
+
+	while (pow2 * 2 <= block_size)
+		pow2 *= 2;
+	return block_size + (pow2 / 4 > 8 ? pow2 / 4 : 8);
+}
+
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
 	size_t block_size;
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
+	for (block_size = 16; block_size < PGSIZE / 2;
+			block_size = next_block_size (block_size)) {
 		struct desc *d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-		list_init (&d->free_list);
+		for (int i = 0; i < ARENA_BINS; i++)
+			list_init (&d->partial[i]);
 		lock_init (&d->lock);
+		lock_set_adaptive (&d->lock);
+	}
+}
+
+/* Returns the block a SIZE-byte request would have taken when
+   every class was a power of two from 16 bytes to PGSIZE / 4, and
+   anything larger got a page of its own. */
+static size_t
+pow2_block_size (size_t size) {
+	size_t pow2 = 16;
+
+	if (size > PGSIZE / 4)
+		return PGSIZE;
+	while (pow2 < size)
+		pow2 *= 2;
+	return pow2;
+}
+
+/* Returns the percentage of ALLOCATED bytes not covered by
+   REQUESTED bytes. */
+static unsigned
+waste_pct (unsigned long long requested, unsigned long long allocated) {
+	return allocated ? 100 - requested * 100 / allocated : 0;
+}
+
+/* Prints how often the descriptor locks were contended, and how
+   many of those acquires avoided a context switch by spinning.
+   Then, for each size class that was used, prints the share of
+   its blocks lost to rounding (internal fragmentation), next to
+   what the same requests would have lost with power-of-two
+   classes. */
+void
+malloc_print_stats (void) {
+	unsigned long long spins = 0, blocks = 0;
+	unsigned long long requested = 0, allocated = 0, pow2_bytes = 0;
+
+	for (size_t i = 0; i < desc_cnt; i++) {
+		spins += descs[i].lock.spin_acquires;
+		blocks += descs[i].lock.spin_blocks;
+	}
+	printf ("Malloc: %llu contended acquires, %llu switches avoided\n",
+			spins + blocks, spins);
+
+	for (size_t i = 0; i < desc_cnt; i++) {
+		struct desc *d = &descs[i];
+		unsigned long long bytes = d->allocs * d->block_size;
+
+		if (d->allocs == 0)
+			continue;
+		printf ("Malloc: %4zu-byte class: %llu allocs, %u%% waste "
+				"(%u%% as 2^n), %zu arenas, %llu released\n",
+				d->block_size, d->allocs, waste_pct (d->requested, bytes),
+				waste_pct (d->requested, d->pow2_bytes), d->arena_cnt,
+				d->released);
+		requested += d->requested;
+		allocated += bytes;
+		pow2_bytes += d->pow2_bytes;
 	}
+	printf ("Malloc: %u%% internal fragmentation (%u%% as 2^n)\n",
+			waste_pct (requested, allocated), waste_pct (requested, pow2_bytes));
+}
+
+/* Returns the partial list of D that arena A belongs on. */
+static struct list *
+arena_bin (struct desc *d, struct arena *a) {
+	ASSERT (a->free_cnt > 0 && a->free_cnt < d->blocks_per_arena);
+	return &d->partial[a->free_cnt * ARENA_BINS / d->blocks_per_arena];
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -85,7 +182,7 @@ void *
 malloc (size_t size) {
 	struct desc *d;
 	struct block *b;
-	struct arena *a;
+	struct arena *a = NULL;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -114,8 +211,16 @@ malloc (size_t size) {
 
 	lock_acquire (&d->lock);
 
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
+	/* Take the fullest arena that still has a free block. */
+	for (int i = 0; i < ARENA_BINS; i++)
+		if (!list_empty (&d->partial[i])) {
+			a = list_entry (list_pop_front (&d->partial[i]),
+					struct arena, elem);
+			break;
+		}
+
+	/* If there is none, create a new arena. */
+	if (a == NULL) {
 		size_t i;
 
 		/* Allocate a page. */
@@ -125,20 +230,27 @@ malloc (size_t size) {
 			return NULL;
 		}
 
-		/* Initialize arena and add its blocks to the free list. */
+		/* Initialize arena and add its blocks to its free list. */
 		a->magic = ARENA_MAGIC;
 		a->desc = d;
 		a->free_cnt = d->blocks_per_arena;
+		list_init (&a->free_list);
 		for (i = 0; i < d->blocks_per_arena; i++) {
 			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
+			list_push_back (&a->free_list, &b->free_elem);
 		}
+		d->arena_cnt++;
 	}
 
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
+	/* Get a block from the arena's free list, and put the arena
+	   back on the partial list its new fill level calls for. */
+	b = list_entry (list_pop_front (&a->free_list), struct block, free_elem);
+	if (--a->free_cnt > 0)
+		list_push_front (arena_bin (d, a), &a->elem);
+
+	d->allocs++;
+	d->requested += size;
+	d->pow2_bytes += pow2_block_size (size);
 	lock_release (&d->lock);
 	return b;
 }
@@ -215,20 +327,21 @@ free (void *p) {
 
 			lock_acquire (&d->lock);
 
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
+			/* Add block to its arena's free list, taking the arena off
+			   the partial list it was on, if any. */
+			if (a->free_cnt > 0)
+				list_remove (&a->elem);
+			list_push_front (&a->free_list, &b->free_elem);
 
-			/* If the arena is now entirely unused, free it. */
+			/* If the arena is now entirely unused, free it.
+			   Otherwise file it under its new fill level. */
 			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
 				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
+				d->arena_cnt--;
+				d->released++;
 				palloc_free_page (a);
-			}
+			} else
+				list_push_front (arena_bin (d, a), &a->elem);
 
 			lock_release (&d->lock);
 		} else {
@@ -2,15 +2,21 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "threads/workqueue.h"
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -24,13 +30,79 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Its free pages form
+   blocks of 2**ORDER pages, aligned to their size relative to
+   the pool's base, on one free list per order.  An allocation
+   splits the smallest large enough block in halves, and a free
+   merges a block with its buddy, the other half of the block it
+   was split from, for as long as the buddy is free too, so both
+   take O(log n) time.  A run of pages that is not a power of two
+   is handed out as the head of a larger block whose tail goes
+   back on the free lists, and is freed as the aligned blocks it
+   decomposes into.
+
+   The free lists are threaded through per-page metadata kept
+   beside the pool's bitmap, not through the free pages, so free
+   memory is never touched.
+
+   Single pages, by far the most common request, are served from
+   magazines in front of the buddy allocator: each CPU caches up
+   to MAG_CAP free pages of each pool, which it allocates and
+   frees with interrupts off instead of taking the pool lock.  An
+   empty cache is refilled, and a full one drained, MAG_SIZE
+   pages at a time, first from or to the pool's depot of full
+   magazines, which balances pages among CPUs, and otherwise from
+   or to the buddy allocator in one locked batch.  When the buddy
+   allocator runs out, the depot and this CPU's cache are given
+   back before failing.
+
+   Each pool also keeps up to ZERO_CAP pages that were zeroed
+   ahead of time, so that a PAL_ZERO request for one page usually
+   skips zeroing it.  Whenever fewer than ZERO_LOW are left, the
+   low priority worker thread tops the stock up, so the zeroing
+   happens while the CPU would otherwise sit idle.  When the stock
+   is empty, the page is zeroed on the spot. */
+
+#define ORDER_CNT (PALLOC_MAX_ORDER + 1)
+#define MAG_SIZE 32                 /* Pages moved per refill or drain. */
+#define MAG_CAP (2 * MAG_SIZE)      /* Pages a CPU caches per pool. */
+#define DEPOT_MAX 8                 /* Full magazines in a depot. */
+#define ZERO_CAP 64                 /* Pre-zeroed pages kept per pool. */
+#define ZERO_LOW 16                 /* Refill below this many. */
+
+/* A CPU's cache of free pages from one pool.  Only touched by its
+   CPU, with interrupts off. */
+struct page_cache {
+	size_t cnt;                     /* Number of pages cached. */
+	void *pages[MAG_CAP];           /* Cached pages, a stack. */
+	long long hits;                 /* Allocations served here. */
+};
 
 /* A memory pool. */
 struct pool {
 	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	struct list free_lists[ORDER_CNT]; /* Free blocks of each order. */
+	size_t free_cnt[ORDER_CNT];     /* Number of blocks in each list. */
+	struct list_elem *links;        /* Per page: free list element. */
+	uint8_t *orders;                /* Per page: order + 1 of the free
+	                                   block it heads, or 0. */
+
+	struct page_cache caches[CPU_MAX]; /* Per-CPU single-page caches. */
+	void *depot[DEPOT_MAX][MAG_SIZE]; /* Full magazines, under lock. */
+	size_t depot_cnt;               /* Number of full magazines. */
+	long long depot_hits;           /* Refills from the depot. */
+	long long refills;              /* Refills from the buddy allocator. */
+
+	struct spinlock zero_lock;      /* Protects the members below. */
+	void *zeroed[ZERO_CAP];         /* Pre-zeroed pages, a stack. */
+	size_t zero_cnt;                /* Number of pre-zeroed pages. */
+	long long zero_hits;            /* PAL_ZERO pages served pre-zeroed. */
+	long long zero_misses;          /* PAL_ZERO pages zeroed on demand. */
+	struct work zero_work;          /* Runs zero_refill(). */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -38,10 +110,24 @@ static struct pool kernel_pool, user_pool;
 
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
+
+/* True once palloc_start_zeroing() has been called. */
+static bool zeroing;
+
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void print_pool_stats (const char *name, struct pool *);
+static struct pool *page_pool (void *page);
+static bool cache_refill (struct pool *, struct page_cache *);
+static void cache_drain (struct pool *, struct page_cache *);
+static void cache_reclaim (struct pool *);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void *zeroed_get (struct pool *);
+static void zero_pages (void *pages, size_t page_cnt);
+static work_func zero_refill;
 
 /* multiboot info */
 struct multiboot_info {
@@ -223,12 +309,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -263,8 +349,20 @@ void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
 
+	if (page_cnt == 0)
+		return NULL;
+	if ((flags & PAL_ZERO) && page_cnt == 1) {
+		void *page = zeroed_get (pool);
+		if (page != NULL)
+			return page;
+	}
+
 	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+	size_t page_idx = buddy_alloc (pool, page_cnt);
+	if (page_idx == BITMAP_ERROR) {
+		cache_reclaim (pool);
+		page_idx = buddy_alloc (pool, page_cnt);
+	}
 	lock_release (&pool->lock);
 	void *pages;
 
@@ -275,7 +373,7 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 
 	if (pages) {
 		if (flags & PAL_ZERO)
-			memset (pages, 0, PGSIZE * page_cnt);
+			zero_pages (pages, page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
 			PANIC ("palloc_get: out of pages");
@@ -293,7 +391,46 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_page (enum palloc_flags flags) {
-	return palloc_get_multiple (flags, 1);
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	struct page_cache *c;
+	enum intr_level old_level;
+	void *page = NULL;
+
+	if (flags & PAL_ZERO) {
+		page = zeroed_get (pool);
+		if (page != NULL)
+			return page;
+	}
+
+	old_level = intr_disable ();
+	c = &pool->caches[cpu_current ()->id];
+	if (c->cnt == 0) {
+		/* Refill under the pool lock, then look again: we may have
+		   slept, and even moved to another CPU, in between. */
+		intr_set_level (old_level);
+		lock_acquire (&pool->lock);
+		old_level = intr_disable ();
+		c = &pool->caches[cpu_current ()->id];
+		if (c->cnt == 0 && !cache_refill (pool, c)) {
+			intr_set_level (old_level);
+			lock_release (&pool->lock);
+			page = palloc_get_multiple (flags & ~PAL_ZERO, 1);
+			if (page == NULL)
+				return NULL;
+		} else {
+			page = c->pages[--c->cnt];
+			intr_set_level (old_level);
+			lock_release (&pool->lock);
+		}
+	} else {
+		page = c->pages[--c->cnt];
+		c->hits++;
+		intr_set_level (old_level);
+	}
+
+	if (flags & PAL_ZERO)
+		zero_pages (page, 1);
+	return page;
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -306,26 +443,300 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 	if (pages == NULL || page_cnt == 0)
 		return;
 
-	if (page_from_pool (&kernel_pool, pages))
-		pool = &kernel_pool;
-	else if (page_from_pool (&user_pool, pages))
-		pool = &user_pool;
-	else
-		NOT_REACHED ();
-
+	pool = page_pool (pages);
 	page_idx = pg_no (pages) - pg_no (pool->base);
 
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
-	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	lock_acquire (&pool->lock);
+	buddy_free (pool, page_idx, page_cnt);
+	lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
 void
 palloc_free_page (void *page) {
-	palloc_free_multiple (page, 1);
+	struct pool *pool;
+	struct page_cache *c;
+	enum intr_level old_level;
+
+	ASSERT (pg_ofs (page) == 0);
+	if (page == NULL)
+		return;
+
+	pool = page_pool (page);
+	ASSERT (bitmap_test (pool->used_map, pg_no (page) - pg_no (pool->base)));
+#ifndef NDEBUG
+	memset (page, 0xcc, PGSIZE);
+#endif
+
+	old_level = intr_disable ();
+	c = &pool->caches[cpu_current ()->id];
+	if (c->cnt == MAG_CAP) {
+		intr_set_level (old_level);
+		lock_acquire (&pool->lock);
+		old_level = intr_disable ();
+		c = &pool->caches[cpu_current ()->id];
+		if (c->cnt == MAG_CAP)
+			cache_drain (pool, c);
+		c->pages[c->cnt++] = page;
+		intr_set_level (old_level);
+		lock_release (&pool->lock);
+	} else {
+		c->pages[c->cnt++] = page;
+		intr_set_level (old_level);
+	}
+}
+
+/* Returns the pool that PAGE belongs to. */
+static struct pool *
+page_pool (void *page) {
+	if (page_from_pool (&kernel_pool, page))
+		return &kernel_pool;
+	else if (page_from_pool (&user_pool, page))
+		return &user_pool;
+	else
+		NOT_REACHED ();
+}
+
+/* Refills empty cache C of pool P with MAG_SIZE pages, from the
+   depot if it has a full magazine, else from the buddy
+   allocator.  Returns false if P has no free pages.  P must be
+   locked and interrupts off.  Pages in caches and the depot stay
+   marked as in use in P's bitmap. */
+static bool
+cache_refill (struct pool *p, struct page_cache *c) {
+	ASSERT (lock_held_by_current_thread (&p->lock));
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (c->cnt == 0);
+
+	if (p->depot_cnt > 0) {
+		memcpy (c->pages, p->depot[--p->depot_cnt], sizeof p->depot[0]);
+		c->cnt = MAG_SIZE;
+		p->depot_hits++;
+		return true;
+	}
+
+	while (c->cnt < MAG_SIZE) {
+		size_t page_idx = buddy_alloc (p, 1);
+		if (page_idx == BITMAP_ERROR)
+			break;
+		c->pages[c->cnt++] = p->base + PGSIZE * page_idx;
+	}
+	p->refills++;
+	return c->cnt > 0;
+}
+
+/* Drains the top MAG_SIZE pages of full cache C of pool P into
+   the depot if it has room, else back to the buddy allocator.
+   P must be locked and interrupts off. */
+static void
+cache_drain (struct pool *p, struct page_cache *c) {
+	ASSERT (lock_held_by_current_thread (&p->lock));
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (c->cnt >= MAG_SIZE);
+
+	c->cnt -= MAG_SIZE;
+	if (p->depot_cnt < DEPOT_MAX)
+		memcpy (p->depot[p->depot_cnt++], &c->pages[c->cnt],
+				sizeof p->depot[0]);
+	else {
+		size_t i;
+		for (i = 0; i < MAG_SIZE; i++)
+			buddy_free (p, pg_no (c->pages[c->cnt + i]) - pg_no (p->base), 1);
+	}
+}
+
+/* Gives every page in pool P's depot, in this CPU's cache, and in
+   its stock of pre-zeroed pages back to the buddy allocator, so
+   that they may merge into larger blocks.  Other CPUs' caches are
+   theirs to touch.  P must be locked. */
+static void
+cache_reclaim (struct pool *p) {
+	enum intr_level old_level = intr_disable ();
+	struct page_cache *c = &p->caches[cpu_current ()->id];
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&p->lock));
+
+	while (p->depot_cnt > 0) {
+		p->depot_cnt--;
+		for (i = 0; i < MAG_SIZE; i++)
+			buddy_free (p, pg_no (p->depot[p->depot_cnt][i]) - pg_no (p->base), 1);
+	}
+	while (c->cnt > 0) {
+		c->cnt--;
+		buddy_free (p, pg_no (c->pages[c->cnt]) - pg_no (p->base), 1);
+	}
+	spin_lock (&p->zero_lock);
+	while (p->zero_cnt > 0) {
+		p->zero_cnt--;
+		buddy_free (p, pg_no (p->zeroed[p->zero_cnt]) - pg_no (p->base), 1);
+	}
+	spin_unlock (&p->zero_lock);
+	intr_set_level (old_level);
+}
+
+/* Starts keeping stocks of pre-zeroed pages, which the low
+   priority worker thread fills.  Must be called after
+   workqueue_init().
+
+   Not under the MLFQS: there the worker, while it waits to run,
+   counts toward load_avg like any ready thread, so PAL_ZERO
+   pages are zeroed by the caller instead. */
+void
+palloc_start_zeroing (void) {
+	if (thread_mlfqs)
+		return;
+	work_init (&kernel_pool.zero_work, zero_refill, &kernel_pool, WORK_LOW);
+	work_init (&user_pool.zero_work, zero_refill, &user_pool, WORK_LOW);
+	zeroing = true;
+	queue_work (&kernel_pool.zero_work);
+	queue_work (&user_pool.zero_work);
+}
+
+/* Takes a page from pool P's stock of pre-zeroed pages and
+   returns it, or returns a null pointer if the stock is empty.
+   Queues a refill when the stock runs low. */
+static void *
+zeroed_get (struct pool *p) {
+	void *page = NULL;
+	bool low;
+
+	spin_lock (&p->zero_lock);
+	if (p->zero_cnt > 0) {
+		page = p->zeroed[--p->zero_cnt];
+		p->zero_hits++;
+	} else
+		p->zero_misses++;
+	low = p->zero_cnt < ZERO_LOW;
+	spin_unlock (&p->zero_lock);
+
+	if (low && zeroing)
+		queue_work (&p->zero_work);
+	return page;
+}
+
+/* Work function: tops pool P_'s stock of pre-zeroed pages up to
+   ZERO_CAP.  Takes only pages that are free in the buddy
+   allocator, never ones that callers could get back by
+   reclaiming caches, so that the stock does not compete with
+   real allocations when memory is short. */
+static void
+zero_refill (void *p_) {
+	struct pool *p = p_;
+
+	while (p->zero_cnt < ZERO_CAP) {
+		size_t page_idx;
+		void *page;
+		bool stored;
+
+		lock_acquire (&p->lock);
+		page_idx = buddy_alloc (p, 1);
+		lock_release (&p->lock);
+		if (page_idx == BITMAP_ERROR)
+			break;
+
+		page = p->base + PGSIZE * page_idx;
+		zero_pages (page, 1);
+
+		spin_lock (&p->zero_lock);
+		stored = p->zero_cnt < ZERO_CAP;
+		if (stored)
+			p->zeroed[p->zero_cnt++] = page;
+		spin_unlock (&p->zero_lock);
+		if (!stored) {
+			palloc_free_page (page);
+			break;
+		}
+	}
+}
+
+/* Fills the PAGE_CNT pages at PAGES with zeros, eight bytes at a
+   time. */
+static void
+zero_pages (void *pages, size_t page_cnt) {
+	size_t cnt = PGSIZE / sizeof (uint64_t) * page_cnt;
+
+	asm volatile ("rep stosq"
+			: "+D" (pages), "+c" (cnt)
+			: "a" (0ULL)
+			: "memory");
+}
+
+/* Prints how often the pool locks were contended, and how many
+   of those acquires avoided a context switch by spinning. */
+void
+palloc_print_stats (void) {
+	unsigned long long spins = kernel_pool.lock.spin_acquires
+		+ user_pool.lock.spin_acquires;
+	unsigned long long blocks = kernel_pool.lock.spin_blocks
+		+ user_pool.lock.spin_blocks;
+
+	printf ("Palloc: %llu contended acquires, %llu switches avoided\n",
+			spins + blocks, spins);
+	print_pool_stats ("kernel", &kernel_pool);
+	print_pool_stats ("user", &user_pool);
+}
+
+/* Prints the free pages of pool P, named NAME, how many free
+   blocks of each order they form, and how its page caches and
+   its stock of pre-zeroed pages did. */
+static void
+print_pool_stats (const char *name, struct pool *p) {
+	size_t free_pages = 0, cached_pages;
+	long long hits = 0;
+	int order, i;
+
+	lock_acquire (&p->lock);
+	cached_pages = p->depot_cnt * MAG_SIZE;
+	for (i = 0; i < cpu_cnt; i++) {
+		cached_pages += p->caches[i].cnt;
+		hits += p->caches[i].hits;
+	}
+	for (order = 0; order < ORDER_CNT; order++)
+		free_pages += p->free_cnt[order] << order;
+	printf ("Palloc %s pool: %zu free pages; free blocks by order:",
+			name, free_pages);
+	for (order = 0; order < ORDER_CNT; order++)
+		if (p->free_cnt[order] > 0)
+			printf (" %d:%zu", order, p->free_cnt[order]);
+	printf ("\n");
+	printf ("Palloc %s pool: %zu pages cached, %lld cache hits, "
+			"%lld depot refills, %lld pool refills\n",
+			name, cached_pages, hits, p->depot_hits, p->refills);
+	printf ("Palloc %s pool: %zu pages pre-zeroed, %lld zero hits, "
+			"%lld zero misses\n",
+			name, p->zero_cnt, p->zero_hits, p->zero_misses);
+	lock_release (&p->lock);
+}
+
+/* Returns the number of free blocks of 2**ORDER pages in the user
+   pool if FLAGS includes PAL_USER, else in the kernel pool.  The
+   blocks of every order together show how fragmented the pool's
+   free memory is. */
+size_t
+palloc_free_blocks (enum palloc_flags flags, int order) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+
+	ASSERT (order >= 0 && order < ORDER_CNT);
+	return pool->free_cnt[order];
+}
+
+/* Stores in *HITS how many single-page PAL_ZERO allocations from
+   the user pool, if FLAGS includes PAL_USER, else from the kernel
+   pool, were served from its stock of pre-zeroed pages, and in
+   *MISSES how many had to be zeroed on demand. */
+void
+palloc_zero_stats (enum palloc_flags flags, long long *hits,
+		long long *misses) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+
+	spin_lock (&pool->zero_lock);
+	*hits = pool->zero_hits;
+	*misses = pool->zero_misses;
+	spin_unlock (&pool->zero_lock);
 }
 
 /* Initializes pool P as starting at START and ending at END */
@@ -333,20 +744,120 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
   /* We'll put the pool's used_map at its base.
      Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
+     and subtract it from the pool's size.
+     The buddy allocator's per-page links and orders follow it. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t links_size = pgcnt * sizeof *p->links;
+	size_t bm_size = ROUND_UP (bitmap_buf_size (pgcnt), sizeof *p->links);
+	size_t bm_pages = DIV_ROUND_UP (links_size + bm_size + pgcnt, PGSIZE)
+		* PGSIZE;
+	uint8_t *buf = *bm_base;
+	int order;
 
 	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	lock_set_adaptive(&p->lock);
+	spin_init (&p->zero_lock);
+	p->links = (struct list_elem *) buf;
+	p->used_map = bitmap_create_in_buf (pgcnt, buf + links_size, bm_size);
+	p->orders = buf + links_size + bm_size;
 	p->base = (void *) start;
+	for (order = 0; order < ORDER_CNT; order++) {
+		list_init (&p->free_lists[order]);
+		p->free_cnt[order] = 0;
+	}
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
+	memset (p->orders, 0, pgcnt);
 
 	*bm_base += bm_pages;
 }
 
+/* Puts the block of 2**ORDER pages at PAGE_IDX in pool P on its
+   free list. */
+static void
+push_block (struct pool *p, size_t page_idx, int order) {
+	p->orders[page_idx] = order + 1;
+	list_push_front (&p->free_lists[order], &p->links[page_idx]);
+	p->free_cnt[order]++;
+}
+
+/* Takes the block of 2**ORDER pages at PAGE_IDX in pool P off its
+   free list. */
+static void
+pull_block (struct pool *p, size_t page_idx, int order) {
+	ASSERT (p->orders[page_idx] == order + 1);
+	p->orders[page_idx] = 0;
+	list_remove (&p->links[page_idx]);
+	p->free_cnt[order]--;
+}
+
+/* Allocates PAGE_CNT contiguous pages from pool P, which must be
+   locked, and returns the index of the first, or BITMAP_ERROR if
+   no free block is large enough. */
+static size_t
+buddy_alloc (struct pool *p, size_t page_cnt) {
+	size_t page_idx;
+	int want = 0, order;
+
+	while (want < ORDER_CNT && ((size_t) 1 << want) < page_cnt)
+		want++;
+	for (order = want; order < ORDER_CNT; order++)
+		if (!list_empty (&p->free_lists[order]))
+			break;
+	if (order == ORDER_CNT)
+		return BITMAP_ERROR;
+
+	page_idx = list_front (&p->free_lists[order]) - p->links;
+	pull_block (p, page_idx, order);
+
+	/* Split off upper halves until the block is just large
+	   enough, then give back the unneeded tail. */
+	while (order > want) {
+		order--;
+		push_block (p, page_idx + ((size_t) 1 << order), order);
+	}
+	bitmap_set_multiple (p->used_map, page_idx, (size_t) 1 << want, true);
+	if (((size_t) 1 << want) > page_cnt)
+		buddy_free (p, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+	return page_idx;
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in pool P, which must be
+   locked or not yet in use, as the largest aligned blocks they
+   divide into, merging each with its buddies. */
+static void
+buddy_free (struct pool *p, size_t page_idx, size_t page_cnt) {
+	size_t pool_pages = bitmap_size (p->used_map);
+
+	ASSERT (bitmap_all (p->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, false);
+
+	while (page_cnt > 0) {
+		size_t idx = page_idx;
+		int order = 0;
+
+		while (order < PALLOC_MAX_ORDER
+				&& (page_idx & ((size_t) 1 << order)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+
+		/* Merge with the buddy while it is a free block of the
+		   same order. */
+		while (order < PALLOC_MAX_ORDER) {
+			size_t buddy = idx ^ ((size_t) 1 << order);
+			if (buddy >= pool_pages || p->orders[buddy] != order + 1)
+				break;
+			pull_block (p, buddy, order);
+			idx &= ~((size_t) 1 << order);
+			order++;
+		}
+		push_block (p, idx, order);
+	}
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
@@ -0,0 +1,235 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator, after Bonwick's "The Slab Allocator: An
+   Object-Caching Kernel Memory Allocator".
+
+   A cache hands out objects of one size, packed at that size
+   (rounded up to their alignment) into page-sized slabs instead
+   of malloc()'s power-of-two blocks.  Each slab begins with a
+   struct slab header followed by a stack of the indexes of its
+   free objects, so that free objects themselves are not written
+   to: a cache with a constructor runs it once, when a slab is
+   created, and objects keep their constructed state across
+   kmem_cache_free() and kmem_cache_alloc().  Callers must free
+   objects in their constructed state.
+
+   A cache keeps its slabs on three lists: partial slabs, which
+   allocation prefers, full slabs, and empty slabs.  Up to
+   SLAB_EMPTY_MAX empty slabs are kept for reuse; more are given
+   back to the page allocator. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* A slab: the header of a page of objects. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of the cache's lists. */
+	size_t free_cnt;            /* Number of free objects. */
+	uint16_t free[];            /* Indexes of free objects, a stack. */
+};
+
+/* All caches, for statistics. */
+static struct list caches;
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+
+/* Initializes the slab allocator. */
+void
+slab_init (void) {
+	list_init (&caches);
+}
+
+/* Creates and returns a cache, named NAME, of objects of SIZE
+   bytes aligned to ALIGN bytes, a power of 2, or to the pointer
+   size if ALIGN is 0.  If CTOR is non-null, it is called on every
+   object when its slab is created.  Panics if SIZE is too large
+   to fit at least two objects in a slab. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c;
+	size_t hdr;
+
+	if (align == 0)
+		align = sizeof (void *);
+	ASSERT ((align & (align - 1)) == 0);
+	ASSERT (size > 0);
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		PANIC ("kmem_cache_create: out of memory");
+	strlcpy (c->name, name, sizeof c->name);
+	c->obj_size = size;
+	c->size = ROUND_UP (size, align);
+	c->align = align;
+	c->ctor = ctor;
+
+	/* Fit as many objects as possible after the header and its
+	   free index stack, which grows by one entry per object. */
+	c->objs_per_slab = (PGSIZE - sizeof (struct slab))
+		/ (c->size + sizeof (uint16_t));
+	for (;; c->objs_per_slab--) {
+		hdr = ROUND_UP (sizeof (struct slab)
+				+ c->objs_per_slab * sizeof (uint16_t), align);
+		if (hdr + c->objs_per_slab * c->size <= PGSIZE)
+			break;
+	}
+	if (c->objs_per_slab < 2)
+		PANIC ("kmem_cache_create: %zu-byte objects are too large", size);
+	c->first_ofs = hdr;
+
+	lock_init (&c->lock);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	c->slab_cnt = c->empty_cnt = c->in_use = 0;
+	list_push_back (&caches, &c->elem);
+	return c;
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	lock_acquire (&c->lock);
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		c->empty_cnt--;
+		list_push_front (&c->partial, &s->elem);
+	} else {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	obj = (uint8_t *) s + c->first_ofs + s->free[--s->free_cnt] * c->size;
+	if (s->free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	c->in_use++;
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C.  A null OBJ is ignored. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab (c, obj);
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs, unless
+	   it must keep its constructed state. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->obj_size);
+#endif
+
+	lock_acquire (&c->lock);
+	ASSERT (s->free_cnt < c->objs_per_slab);
+	if (s->free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	s->free[s->free_cnt++] = ((uint8_t *) obj - (uint8_t *) s - c->first_ofs)
+		/ c->size;
+	c->in_use--;
+
+	if (s->free_cnt == c->objs_per_slab) {
+		list_remove (&s->elem);
+		if (c->empty_cnt < SLAB_EMPTY_MAX) {
+			list_push_front (&c->empty, &s->elem);
+			c->empty_cnt++;
+		} else {
+			c->slab_cnt--;
+			s->magic = 0;
+			palloc_free_page (s);
+		}
+	}
+	lock_release (&c->lock);
+}
+
+/* Prints each cache's occupancy and the bytes its slabs spend on
+   anything other than allocated objects' requested sizes. */
+void
+kmem_cache_print_stats (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+		size_t capacity, wasted;
+
+		lock_acquire (&c->lock);
+		capacity = c->slab_cnt * c->objs_per_slab;
+		wasted = c->slab_cnt * PGSIZE - c->in_use * c->obj_size;
+		printf ("Slab %s: %zu of %zu %zu-byte objects in use, "
+				"%zu slabs (%zu partial, %zu full, %zu empty), "
+				"%zu bytes wasted\n",
+				c->name, c->in_use, capacity, c->obj_size, c->slab_cnt,
+				list_size (&c->partial), list_size (&c->full), c->empty_cnt,
+				wasted);
+		lock_release (&c->lock);
+	}
+}
+
+/* Creates a slab of cache C, which must be locked, with all of
+   its objects free and constructed.  Returns a null pointer if
+   memory is not available. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (0);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->free_cnt = c->objs_per_slab;
+
+	/* Hand out low addresses first. */
+	for (i = 0; i < c->objs_per_slab; i++) {
+		s->free[i] = c->objs_per_slab - 1 - i;
+		if (c->ctor != NULL)
+			c->ctor ((uint8_t *) s + c->first_ofs + i * c->size);
+	}
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns the slab of cache C that OBJ is inside. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid and that the object is
+	   properly aligned within it. */
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+	ASSERT (pg_ofs (obj) >= c->first_ofs);
+	ASSERT ((pg_ofs (obj) - c->first_ofs) % c->size == 0);
+
+	return s;
+}
@@ -0,0 +1,99 @@
+#include "threads/softirq.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "intrinsic.h"
+
+/* Rounds of softirqs softirq_run() makes before it leaves the
+   rest for the next interrupt, so that a storm of interrupts
+   cannot keep the interrupted thread from ever running. */
+#define SOFTIRQ_RESTART_MAX 4
+
+/* A softirq handler and its statistics. */
+struct softirq {
+	softirq_func *func;         /* Handler. */
+	const char *name;           /* Name, for statistics. */
+	long long cnt;              /* Number of runs. */
+	uint64_t cycles;            /* Total TSC cycles spent running. */
+	uint64_t max_cycles;        /* Longest run. */
+};
+
+static struct softirq softirqs[SOFTIRQ_CNT];
+static unsigned pending;        /* Bit N set if softirq N is raised. */
+static bool in_softirq;         /* Is softirq_run() running handlers? */
+
+/* Registers FUNC, called NAME, as the handler for softirq TYPE. */
+void
+softirq_register (enum softirq_type type, softirq_func *func,
+		const char *name) {
+	ASSERT (type < SOFTIRQ_CNT);
+	ASSERT (softirqs[type].func == NULL);
+
+	softirqs[type].func = func;
+	softirqs[type].name = name;
+}
+
+/* Marks softirq TYPE to run when the current external interrupt
+   returns, or when the next one does if we are not in one. */
+void
+softirq_raise (enum softirq_type type) {
+	enum intr_level old_level = intr_disable ();
+
+	ASSERT (softirqs[type].func != NULL);
+	pending |= 1u << type;
+	intr_set_level (old_level);
+}
+
+/* Runs the raised softirqs with interrupts on, then returns with
+   them off again.  Called by intr_handler() once an external
+   interrupt has been acknowledged.  Does nothing if softirqs
+   are already running further up the stack. */
+void
+softirq_run (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (in_softirq || pending == 0)
+		return;
+
+	in_softirq = true;
+	for (int round = 0; pending != 0 && round < SOFTIRQ_RESTART_MAX;
+			round++) {
+		unsigned raised = pending;
+		pending = 0;
+
+		intr_enable ();
+		for (int i = 0; i < SOFTIRQ_CNT; i++)
+			if (raised & (1u << i)) {
+				struct softirq *s = &softirqs[i];
+				uint64_t start = rdtsc ();
+				uint64_t cycles;
+
+				s->func ();
+				cycles = rdtsc () - start;
+				s->cnt++;
+				s->cycles += cycles;
+				if (cycles > s->max_cycles)
+					s->max_cycles = cycles;
+			}
+		intr_disable ();
+	}
+	in_softirq = false;
+}
+
+/* Returns true while softirq handlers are running. */
+bool
+softirq_active (void) {
+	return in_softirq;
+}
+
+/* Prints softirq statistics. */
+void
+softirq_print_stats (void) {
+	for (int i = 0; i < SOFTIRQ_CNT; i++) {
+		const struct softirq *s = &softirqs[i];
+		if (s->cnt > 0)
+			printf ("Softirq %s: %lld runs, avg %llu cycles, max %llu cycles\n",
+					s->name, s->cnt, s->cycles / s->cnt, s->max_cycles);
+	}
+}
@@ -31,6 +31,19 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef LOCK_STAT
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+static struct lock_stat *lock_stat_find(const char *file, int line);
+static void lock_stat_acquired(struct lock *, uint64_t start, bool contended);
+static void lock_stat_released(struct lock *);
+#endif
+
+static void lock_spin(struct lock *);
+static void waiter_push(struct pqueue *, struct thread *);
+static bool waiter_wake(struct pqueue *);
+static void sema_wake(struct semaphore *);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -46,7 +59,59 @@ void sema_init(struct semaphore *sema, unsigned value)
 	ASSERT(sema != NULL);
 
 	sema->value = value;
-	list_init(&sema->waiters);
+	pq_init(&sema->waiters);
+}
+
+/* Queues T, which is about to block, on wait queue Q by its
+   priority.  Unless T is already waiting in a condition
+   variable's queue, Q becomes the one a priority donation to T
+   re-keys.  Interrupts must be off. */
+static void
+waiter_push(struct pqueue *q, struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	pq_push(q, &t->wait_elem, t->priority);
+	if (t->waitq == NULL)
+	{
+		t->waitq = q;
+		t->waitq_elem = &t->wait_elem;
+	}
+}
+
+/* Unblocks the thread that E, taken out of wait queue Q, belongs
+   to. */
+static void
+waiter_unblock(struct pqueue_elem *e, void *q)
+{
+	struct thread *t = pq_entry(e, struct thread, wait_elem);
+
+	if (t->waitq == q)
+		t->waitq = NULL;
+	thread_unblock(t);
+}
+
+/* Unblocks the highest-priority waiter in Q, if any, without
+   yielding, and returns true if there was one.  O(log n).
+   Interrupts must be off. */
+static bool
+waiter_wake(struct pqueue *q)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (pq_empty(q))
+		return false;
+	waiter_unblock(pq_pop(q), q);
+	return true;
+}
+
+/* Increments SEMA's value and unblocks its highest-priority
+   waiter, if any, without yielding.  Interrupts must be off. */
+static void
+sema_wake(struct semaphore *sema)
+{
+	waiter_wake(&sema->waiters);
+	sema->value++;
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -67,8 +132,7 @@ void sema_down(struct semaphore *sema)
 	old_level = intr_disable();
 	while (sema->value == 0)
 	{
-		// list_push_back(&sema->waiters, &thread_current()->elem);
-		list_insert_ordered(&sema->waiters, &thread_current()->elem, cmp_priority, NULL);
+		waiter_push(&sema->waiters, thread_current());
 		thread_block();
 	}
 	sema->value--;
@@ -111,14 +175,7 @@ void sema_up(struct semaphore *sema)
 	ASSERT(sema != NULL);
 
 	old_level = intr_disable();
-	if (!list_empty(&sema->waiters))
-	{
-
-		list_sort(&sema->waiters, cmp_priority, NULL);
-		thread_unblock(list_entry(list_pop_front(&sema->waiters),
-								  struct thread, elem));
-	}
-	sema->value++;
+	sema_wake(sema);
 	test_max_priority();
 	intr_set_level(old_level);
 }
@@ -174,12 +231,59 @@ sema_test_helper(void *sema_)
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
+#ifdef LOCK_STAT
+void lock_init_at(struct lock *lock, const char *file, int line)
+#else
 void lock_init(struct lock *lock)
+#endif
 {
 	ASSERT(lock != NULL);
 
 	lock->holder = NULL;
 	sema_init(&lock->semaphore, 1);
+	lock->hold.waiters[0] = &lock->semaphore.waiters;
+	lock->hold.waiters[1] = NULL;
+	lock->adaptive = false;
+	lock->spin_acquires = lock->spin_blocks = 0;
+#ifdef LOCK_STAT
+	lock->stat = lock_stat_find(file, line);
+#endif
+}
+
+/* Puts LOCK in adaptive mode, for short critical sections that
+   do not sleep: lock_acquire() first spins for as long as the
+   holder is running on another CPU, on the bet that it will
+   release the lock sooner than a block and a context switch
+   would take, and only blocks if the holder stops running or
+   the spin runs too long.  A holder that is not running cannot
+   release the lock, so on a single CPU this never spins, and
+   LOCK's spin_blocks just counts contended acquires. */
+void lock_set_adaptive(struct lock *lock)
+{
+	ASSERT(lock != NULL);
+
+	lock->adaptive = true;
+}
+
+/* Most iterations lock_spin() waits for a running holder. */
+#define LOCK_SPIN_MAX 1000
+
+/* Spins while LOCK is held by a thread that is running on
+   another CPU, for at most LOCK_SPIN_MAX iterations.  A holder
+   that exits frees its struct thread only after switching away,
+   and its page stays mapped, so reading its status here is
+   harmless even if it is stale. */
+static void
+lock_spin(struct lock *lock)
+{
+	for (int i = 0; i < LOCK_SPIN_MAX; i++)
+	{
+		struct thread *holder = lock->holder;
+		if (lock->semaphore.value != 0 || holder == NULL
+			|| holder->status != THREAD_RUNNING)
+			break;
+		asm volatile("pause" : : : "memory");
+	}
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -197,25 +301,42 @@ void lock_acquire(struct lock *lock)
 	ASSERT(!intr_context());
 	ASSERT(!lock_held_by_current_thread(lock));
 
+#ifdef LOCK_STAT
+	uint64_t start = rdtsc();
+	bool contended = lock->semaphore.value == 0;
+#endif
+	// adaptive 락은 holder 가 다른 CPU 에서 실행중이면 block 하기 전에 잠깐 spin 한다.
+	bool spun = lock->adaptive && lock->semaphore.value == 0;
+	if (spun)
+		lock_spin(lock);
+
 	enum intr_level old_level = intr_disable();
-	// lock을 점유하고있는 스레드와 요청하는 스레드의 우선순위 비교하여 p donation
-	// 락이 점유 되어있는 경우, wait 해야함.
+	if (spun)
+	{
+		if (lock->semaphore.value != 0)
+			lock->spin_acquires++;
+		else
+			lock->spin_blocks++;
+	}
+	// 락이 점유 되어있는 경우, 세마포어 큐에서 wait 해야함.
+	// 큐에 들어간 뒤 holder 에게 priority donation 을 한다.
 	struct thread *t = thread_current();
-	if (lock->holder != NULL)
+	while (lock->semaphore.value == 0)
 	{
-		// donators에 추가
-
-		t->wait_on_lock = lock;
-		list_insert_ordered(&lock->holder->donators, &t->d_elem, cmp_dpriority, NULL);
-		priority_donate(lock);
+		waiter_push(&lock->semaphore.waiters, t);
+		if (!thread_mlfqs)
+			priority_donate(lock);
+		thread_block();
 	}
+	lock->semaphore.value--;
 
-	sema_down(&lock->semaphore);
-
-	t->wait_on_lock = NULL;
 	lock->holder = t;
+	if (!thread_mlfqs)
+		priority_hold_acquired(&lock->hold);
+#ifdef LOCK_STAT
+	lock_stat_acquired(lock, start, contended);
+#endif
 	intr_set_level(old_level);
-	// lock->holder = thread_current();
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -231,9 +352,18 @@ bool lock_try_acquire(struct lock *lock)
 	ASSERT(lock != NULL);
 	ASSERT(!lock_held_by_current_thread(lock));
 
+	enum intr_level old_level = intr_disable();
 	success = sema_try_down(&lock->semaphore);
 	if (success)
+	{
 		lock->holder = thread_current();
+		if (!thread_mlfqs)
+			priority_hold_acquired(&lock->hold);
+#ifdef LOCK_STAT
+		lock_stat_acquired(lock, rdtsc(), false);
+#endif
+	}
+	intr_set_level(old_level);
 	return success;
 }
 
@@ -248,12 +378,17 @@ void lock_release(struct lock *lock)
 	ASSERT(lock != NULL);
 	ASSERT(lock_held_by_current_thread(lock));
 
-	// lock을 해제한 후, 현재 스레드의 대기 리스트 갱신
-	remove_with_lock(lock);
-	// priority를 donation받았을 수 있으므로 원래의 p로 초기화
-	// refresh_priority();
+	// lock을 해제한 후, 기부받은 priority 를 돌려놓는다.
+	// MLFQS 에서는 donation 을 하지 않는다.
+	enum intr_level old_level = intr_disable();
+#ifdef LOCK_STAT
+	lock_stat_released(lock);
+#endif
+	if (!thread_mlfqs)
+		priority_hold_released(&lock->hold);
 	lock->holder = NULL;
 	sema_up(&lock->semaphore);
+	intr_set_level(old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -266,28 +401,179 @@ bool lock_held_by_current_thread(const struct lock *lock)
 	return lock->holder == thread_current();
 }
 
-/* One semaphore in a list. */
-struct semaphore_elem
+/* Initializes RW as an unheld reader-writer lock.  Readers
+   share it with each other but not with a writer, and a
+   waiting writer keeps new readers out, so writers are never
+   starved by readers.  Blocked threads of either kind donate
+   their priority to all of the current holders, unless
+   thread_mlfqs. */
+void rw_init(struct rwlock *rw)
 {
-	struct list_elem elem;		/* List element. */
-	struct semaphore semaphore; /* This semaphore. */
-};
+	ASSERT(rw != NULL);
+
+	rw->writer = NULL;
+	rw->readers = 0;
+	rw->writers_waiting = 0;
+	list_init(&rw->holders);
+	pq_init(&rw->read_waiters);
+	pq_init(&rw->write_waiters);
+}
 
-bool cmp_sem_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+/* Returns the current thread's hold on RW, or NULL if it does
+   not hold RW.  With RW null, returns a free slot instead. */
+static struct rw_hold *
+rw_hold_find(const struct rwlock *rw)
 {
-	struct semaphore_elem *sema_a = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sema_b = list_entry(b, struct semaphore_elem, elem);
+	struct thread *t = thread_current();
 
-	// 세마포어 대기 큐에서 가장 높은 우선순위를 가진 스레드 찾기
-	struct thread *thread_a = list_entry(list_front(&sema_a->semaphore.waiters),
-										 struct thread, elem);
-	struct thread *thread_b = list_entry(list_front(&sema_b->semaphore.waiters),
-										 struct thread, elem);
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+		if (t->rw_holds[i].rw == rw)
+			return &t->rw_holds[i];
+	return NULL;
+}
 
-	// 두 스레드의 우선순위 비교
-	return (thread_a->priority > thread_b->priority);
+/* Records that the current thread now holds RW, in one of its
+   free rw_holds slots.  Interrupts must be off. */
+static void
+rw_hold_take(struct rwlock *rw)
+{
+	struct rw_hold *h = rw_hold_find(NULL);
+
+	if (h == NULL)
+		PANIC("thread holds more than %d rwlocks", RW_HOLD_MAX);
+	h->rw = rw;
+	h->thread = thread_current();
+	h->hold.waiters[0] = &rw->write_waiters;
+	h->hold.waiters[1] = &rw->read_waiters;
+	list_push_back(&rw->holders, &h->elem);
+	if (!thread_mlfqs)
+		priority_hold_acquired(&h->hold);
+}
+
+/* Releases hold H and frees its slot.  Interrupts must be off. */
+static void
+rw_hold_drop(struct rw_hold *h)
+{
+	list_remove(&h->elem);
+	if (!thread_mlfqs)
+		priority_hold_released(&h->hold);
+	h->rw = NULL;
 }
 
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.  The current thread must not already hold
+   RW in either mode.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rw_read_acquire(struct rwlock *rw)
+{
+	struct thread *t = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	old_level = intr_disable();
+	ASSERT(rw_hold_find(rw) == NULL);
+	while (rw->writer != NULL || rw->writers_waiting > 0)
+	{
+		waiter_push(&rw->read_waiters, t);
+		if (!thread_mlfqs)
+			priority_donate_rw(rw);
+		thread_block();
+	}
+	rw->readers++;
+	rw_hold_take(rw);
+	intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   The last reader out hands the lock to the highest-priority
+   waiting writer, if any. */
+void rw_read_release(struct rwlock *rw)
+{
+	struct rw_hold *h;
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+
+	old_level = intr_disable();
+	h = rw_hold_find(rw);
+	ASSERT(h != NULL && rw->writer == NULL && rw->readers > 0);
+	rw_hold_drop(h);
+	if (--rw->readers == 0)
+		waiter_wake(&rw->write_waiters);
+	test_max_priority();
+	intr_set_level(old_level);
+}
+
+/* Acquires RW for writing, sleeping until no reader or writer
+   holds it.  From the moment it is called, new readers wait.
+   The current thread must not already hold RW in either mode.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rw_write_acquire(struct rwlock *rw)
+{
+	struct thread *t = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	old_level = intr_disable();
+	ASSERT(rw_hold_find(rw) == NULL);
+	rw->writers_waiting++;
+	while (rw->writer != NULL || rw->readers > 0)
+	{
+		waiter_push(&rw->write_waiters, t);
+		if (!thread_mlfqs)
+			priority_donate_rw(rw);
+		thread_block();
+	}
+	rw->writers_waiting--;
+	rw->writer = t;
+	rw_hold_take(rw);
+	intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing.
+   Wakes the highest-priority waiting writer if there is one,
+   otherwise every waiting reader. */
+void rw_write_release(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw_write_held_by_current_thread(rw));
+
+	old_level = intr_disable();
+	rw_hold_drop(rw_hold_find(rw));
+	rw->writer = NULL;
+	if (!waiter_wake(&rw->write_waiters))
+		pq_drain(&rw->read_waiters, waiter_unblock, &rw->read_waiters);
+	test_max_priority();
+	intr_set_level(old_level);
+}
+
+/* Returns true if the current thread holds RW for writing,
+   false otherwise. */
+bool rw_write_held_by_current_thread(const struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	return rw->writer == thread_current();
+}
+
+/* One semaphore in a condition variable's queue. */
+struct semaphore_elem
+{
+	struct pqueue_elem elem;	/* Queue element, keyed by priority. */
+	struct semaphore semaphore; /* This semaphore. */
+	struct thread *thread;		/* The waiting thread. */
+};
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -295,7 +581,7 @@ void cond_init(struct condition *cond)
 {
 	ASSERT(cond != NULL);
 
-	list_init(&cond->waiters);
+	pq_init(&cond->waiters);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -327,9 +613,19 @@ void cond_wait(struct condition *cond, struct lock *lock)
 	ASSERT(!intr_context());
 	ASSERT(lock_held_by_current_thread(lock));
 
+	struct thread *t = thread_current();
+	enum intr_level old_level;
+
 	sema_init(&waiter.semaphore, 0);
-	// list_push_back(&cond->waiters, &waiter.elem);
-	list_insert_ordered(&cond->waiters, &waiter.elem, cmp_priority, NULL);
+	waiter.thread = t;
+
+	// cond 큐에서 기다리는 동안 donation 은 cond 큐에서 re-key 된다.
+	old_level = intr_disable();
+	pq_push(&cond->waiters, &waiter.elem, t->priority);
+	t->waitq = &cond->waiters;
+	t->waitq_elem = &waiter.elem;
+	intr_set_level(old_level);
+
 	lock_release(lock);
 	sema_down(&waiter.semaphore);
 	lock_acquire(lock);
@@ -349,19 +645,39 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED)
 	ASSERT(!intr_context());
 	ASSERT(lock_held_by_current_thread(lock));
 
-	if (!list_empty(&cond->waiters))
+	enum intr_level old_level = intr_disable();
+	if (!pq_empty(&cond->waiters))
 	{
-
-		list_sort(&cond->waiters, cmp_sem_priority, NULL);
-		sema_up(&list_entry(list_pop_front(&cond->waiters),
-							struct semaphore_elem, elem)
-					 ->semaphore);
+		struct semaphore_elem *waiter = pq_entry(pq_pop(&cond->waiters),
+												 struct semaphore_elem, elem);
+		waiter->thread->waitq = NULL;
+		sema_up(&waiter->semaphore);
 	}
+	intr_set_level(old_level);
+}
+
+/* Wakes the waiter that owns E, which cond_broadcast() has
+   taken out of a condition variable's queue.  Interrupts must be
+   off. */
+static void
+cond_wake(struct pqueue_elem *e, void *aux UNUSED)
+{
+	struct semaphore_elem *waiter = pq_entry(e, struct semaphore_elem, elem);
+
+	waiter->thread->waitq = NULL;
+	sema_wake(&waiter->semaphore);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
    LOCK).  LOCK must be held before calling this function.
 
+   The waiters are woken in the order cond_signal() would pick
+   them, highest priority first and FIFO among equal priorities,
+   so that they also run in that order.  This takes O(n log n)
+   time, one pq_pop() per waiter; pq_drain() would take O(n) but
+   visits the heap in no particular order.  The current thread
+   yields at most once, after all of them are awake.
+
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
    interrupt handler. */
@@ -370,8 +686,121 @@ void cond_broadcast(struct condition *cond, struct lock *lock)
 	ASSERT(cond != NULL);
 	ASSERT(lock != NULL);
 
-	while (!list_empty(&cond->waiters))
-		cond_signal(cond, lock);
+	ASSERT(!intr_context());
+	ASSERT(lock_held_by_current_thread(lock));
+
+	enum intr_level old_level = intr_disable();
+	while (!pq_empty(&cond->waiters))
+		cond_wake(pq_pop(&cond->waiters), NULL);
+	test_max_priority();
+	intr_set_level(old_level);
+}
+
+#ifdef LOCK_STAT
+/* Most lock_init() call sites tracked.  Locks initialized at
+   further sites share the last entry. */
+#define LOCK_STAT_MAX 64
+
+static struct lock_stat lock_stats[LOCK_STAT_MAX];
+static int lock_stat_cnt;
+
+/* Returns the statistics for the lock_init() call at FILE:LINE,
+   adding an entry for it if it is new. */
+static struct lock_stat *
+lock_stat_find(const char *file, int line)
+{
+	struct lock_stat *s;
+	enum intr_level old_level = intr_disable();
+	int i;
+
+	/* Call sites are printed relative to the source tree. */
+	while (file[0] == '.' && file[1] == '.' && file[2] == '/')
+		file += 3;
+
+	for (i = 0; i < lock_stat_cnt; i++)
+		if (lock_stats[i].line == line && !strcmp(lock_stats[i].file, file))
+			break;
+	if (i < lock_stat_cnt)
+		s = &lock_stats[i];
+	else if (lock_stat_cnt < LOCK_STAT_MAX - 1)
+	{
+		s = &lock_stats[lock_stat_cnt++];
+		s->file = file;
+		s->line = line;
+	}
+	else
+	{
+		s = &lock_stats[LOCK_STAT_MAX - 1];
+		s->file = "(other)";
+		lock_stat_cnt = LOCK_STAT_MAX;
+	}
+	intr_set_level(old_level);
+	return s;
+}
+
+/* Accounts for an acquire of LOCK that started at TSC START and
+   has just succeeded.  Interrupts must be off. */
+static void
+lock_stat_acquired(struct lock *lock, uint64_t start, bool contended)
+{
+	struct lock_stat *s = lock->stat;
+	uint64_t now = rdtsc();
+	uint64_t wait = now - start;
+
+	s->acquired++;
+	if (contended)
+		s->contended++;
+	s->wait_total += wait;
+	if (wait > s->wait_max)
+		s->wait_max = wait;
+	lock->acquired_at = now;
+}
+
+/* Accounts for the time LOCK was held, as it is released.
+   Interrupts must be off. */
+static void
+lock_stat_released(struct lock *lock)
+{
+	lock->stat->hold_total += rdtsc() - lock->acquired_at;
+}
+
+/* Converts CYCLES of the TSC to microseconds. */
+static unsigned long long
+cycles_to_us(uint64_t cycles)
+{
+	uint64_t hz = timer_tsc_hz();
+	return hz >= 1000000 ? cycles / (hz / 1000000) : 0;
+}
+
+/* Prints the statistics of every lock_init() call site whose
+   locks were acquired, most total wait time first. */
+void lock_stat_print(void)
+{
+	uint8_t order[LOCK_STAT_MAX];
+	int cnt = lock_stat_cnt;
+	int i, j;
+
+	/* Insertion sort of the indexes.  printf() takes the console
+	   lock, so its entry may still change while we print. */
+	for (i = 0; i < cnt; i++)
+	{
+		uint64_t wait = lock_stats[i].wait_total;
+		for (j = i; j > 0 && lock_stats[order[j - 1]].wait_total < wait; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+
+	printf("Lock stats (us): acquired contended wait-total wait-max "
+		   "hold-total site\n");
+	for (i = 0; i < cnt; i++)
+	{
+		const struct lock_stat *s = &lock_stats[order[i]];
+		if (s->acquired == 0)
+			continue;
+		printf("%10llu %9llu %10llu %8llu %10llu %s:%d\n",
+			   s->acquired, s->contended, cycles_to_us(s->wait_total),
+			   cycles_to_us(s->wait_max), cycles_to_us(s->hold_total),
+			   s->file, s->line);
+	}
 }
-// todo ???
-/* 두개의 세마포어가 가지고있는 스레드들의 최대 우선순위를 비교 */
+#endif /* LOCK_STAT */
@@ -1,9 +1,15 @@
 threads_SRC  = threads/init.c		# Main program.
 threads_SRC += threads/thread.c		# Thread management core.
+threads_SRC += threads/cpu.c		# Per-CPU data.
+threads_SRC += threads/trace.c		# Scheduler event tracing.
 threads_SRC += threads/interrupt.c	# Interrupt core.
+threads_SRC += threads/softirq.c	# Interrupt bottom halves.
+threads_SRC += threads/workqueue.c	# Deferred work in kernel threads.
+threads_SRC += threads/apic.c		# Local APIC and IOAPIC.
 threads_SRC += threads/intr-stubs.S	# Interrupt stubs.
 threads_SRC += threads/synch.c		# Synchronization.
 threads_SRC += threads/palloc.c		# Page allocator.
 threads_SRC += threads/malloc.c		# Subpage allocator.
+threads_SRC += threads/slab.c		# Object caches.
 threads_SRC += threads/start.S		# Startup code.
 threads_SRC += threads/mmu.c		    # Memory management unit related things.
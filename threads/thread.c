@@ -1,14 +1,19 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <limits.h>
 #include <stddef.h>
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/softirq.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 #ifdef USERPROG
@@ -24,32 +29,90 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-// ticks에 도달하지 않은 스레드를 담을 연결 리스트 sleep_list 선언, thread_init에서 초기화
-static struct list sleep_list;
+/* Each CPU has its own run queue, idle thread, time slice
+   counter and statistics in its struct cpu (see cpu.h).  Threads
+   that become ready go on the run queue of the CPU that readied
+   them.  Only the boot CPU is started, so there is no balancing
+   between queues. */
+
+/* If true, use the completely fair scheduler instead: ready
+   threads are kept in rq->cfs_queue, a red-black tree ordered by
+   virtual runtime, and the thread that has received the least
+   weighted CPU time runs next.  Controlled by kernel
+   command-line option "-cfs". */
+bool thread_cfs;
+
+/* If true, print the wakeup latency histograms at power off.
+   Controlled by kernel command-line option "-latency". */
+bool thread_latency;
+
+/* Virtual runtime is measured in units of 1/NICE_0_WEIGHT of a
+   tick of CPU time at nice 0.  A thread of weight W that runs
+   for one tick advances its vruntime by NICE_0_WEIGHT**2 / W. */
+#define NICE_0_WEIGHT 1024
+#define CFS_LATENCY 6			/* Ticks in which each ready thread should run. */
+#define CFS_MIN_GRANULARITY 1	/* Shortest time slice, in ticks. */
+#define CFS_WAKEUP_GRANULARITY NICE_0_WEIGHT /* vruntime lead needed to preempt. */
+
+/* CFS weight for each niceness from NICE_MIN to NICE_MAX.  Each
+   step of niceness is worth about 10% of CPU time. */
+static const unsigned cfs_nice_to_weight[NICE_MAX - NICE_MIN + 1] = {
+	/* -20 */ 88761, 71755, 56483, 46273, 36291,
+	/* -15 */ 29154, 23254, 18705, 14949, 11916,
+	/* -10 */ 9548, 7620, 6100, 4904, 3906,
+	/*  -5 */ 3121, 2501, 1991, 1586, 1277,
+	/*   0 */ 1024, 820, 655, 526, 423,
+	/*   5 */ 335, 272, 215, 172, 137,
+	/*  10 */ 110, 87, 70, 56, 45,
+	/*  15 */ 36, 29, 23, 18, 15,
+	/*  20 */ 12,
+};
+
+/* Earliest-deadline-first class.  Threads that have called
+   thread_set_deadline() run ahead of every other class, in
+   order of absolute deadline, as long as they have budget left
+   in their current period.  rq->dl_queue holds the ready ones. */
+
+/* Total CPU bandwidth reserved by EDF threads, as a fraction of
+   1 << DL_BW_SHIFT.  thread_set_deadline() refuses reservations
+   that would raise it above thread_edf_bound percent.
+   Controlled by kernel command-line option "-edf-bound=PCT". */
+#define DL_BW_SHIFT 20
+
+/* Longest period thread_set_deadline() accepts, in ticks.  It
+   keeps RUNTIME << DL_BW_SHIFT, budget times period, and the
+   absolute deadline well inside 64 bits. */
+#define DL_PERIOD_MAX INT32_MAX
+static uint64_t dl_total_bw;
+int thread_edf_bound = 95;
+
+/* List of all live threads, for the once-per-second MLFQS
+   recalculation. */
+static struct list all_list;
 
 // lock 에 등록을 하고싶은 쓰레드의 리스트
 static struct list wait_list;
 
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
 /* Lock used by allocate_tid(). */
-static struct lock tid_lock;
+static struct spinlock tid_lock;
 
-/* Thread destruction requests */
+/* Thread destruction requests.  The pages of threads that have
+   exited and switched away, most recently exited at the back.
+   thread_create() recycles them; the reaper frees the excess
+   once there are more than THREAD_CACHE_MAX. */
 static struct list destruction_req;
+static size_t destruction_cnt;	  /* Number of pages in destruction_req. */
+#define THREAD_CACHE_MAX 32		  /* Dead thread pages kept for reuse. */
+
+/* Wakes the reaper when destruction_req has grown too long. */
+static struct semaphore reap_sema;
 
 /* Statistics. */
-static long long idle_ticks;   /* # of timer ticks spent idle. */
-static long long kernel_ticks; /* # of timer ticks in kernel threads. */
-static long long user_ticks;   /* # of timer ticks in user programs. */
+static long long pages_recycled; /* Thread pages reused from the cache. */
+static long long pages_allocated; /* Thread pages from palloc. */
 
 /* Scheduling. */
 // 프로세스가 cpu를 할당받아 실행하는 시간의 단위.
@@ -57,21 +120,71 @@ static long long user_ticks;   /* # of timer ticks in user programs. */
 // cpu를 넘겨주게 됨. 모든 프로세스가 공정하게 CPU시간을 할당받을 수 있음.
 // 각 작업에 할당되는 시간 단위
 #define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
+
+/* Time slice of each priority, in timer ticks, for the priority
+   scheduler and the MLFQS, or 0 for TIME_SLICE.  Set by
+   thread_set_timeslice(), which the "-slice=LO[-HI]:TICKS" kernel
+   command-line option calls before thread_init(). */
+static unsigned time_slices[PRI_MAX + 1];
+
+/* Wakeup latency histogram of all threads: bucket i counts the
+   wakeups that waited 2**i to 2**(i+1) - 1 TSC cycles between
+   thread_unblock() and being switched to. */
+static unsigned latency_hist[LATENCY_BUCKETS];
+
+/* Priority donation. */
+#define DONATE_DEPTH_MAX 8	  /* Longest chain of holders donated to. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
-   Controlled by kernel command-line option "-o mlfqs". */
+   Controlled by kernel command-line option "-mlfqs". */
 bool thread_mlfqs;
 
+/* System load average, for the MLFQS. */
+static fixed_t load_avg;
+
 static void kernel_thread(thread_func *, void *aux);
+static void latency_record(struct thread *);
+static void latency_print_hist(const char *name, const unsigned hist[]);
 
 static void idle(void *aux UNUSED);
+static void reaper(void *aux UNUSED);
+static struct thread *thread_page_get(void);
+static timer_func thread_wake;
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
+static void rq_init(struct runqueue *);
+static void rq_push(struct runqueue *, struct thread *);
+static struct thread *rq_pop(struct runqueue *);
+static void ready_push(struct thread *);
+static struct thread *ready_pop(void);
+static void ready_remove(struct thread *);
+static int ready_max_priority(void);
+static int ready_threads(void);
+static bool thread_is_idle(const struct thread *);
+static unsigned thread_timeslice(struct thread *);
+static bool cfs_less(const struct rb_elem *, const struct rb_elem *, void *aux);
+static unsigned cfs_weight(const struct thread *);
+static void cfs_place(struct thread *);
+static void cfs_update_min_vruntime(struct thread *);
+static bool cfs_should_preempt(struct thread *);
+static bool edf_less(const struct rb_elem *, const struct rb_elem *, void *aux);
+static bool thread_is_edf(const struct thread *);
+static void edf_place(struct thread *);
+static void edf_charge(struct thread *);
+static void edf_replenish(void *t_);
+static int mlfqs_priority(const struct thread *);
+static int hold_priority(const struct hold *);
+static bool held_lock_less(const struct pheap_elem *, const struct pheap_elem *,
+						   void *aux);
+static int effective_priority(struct thread *);
+static void donate(struct thread *, struct hold *, tid_t donor, int depth);
+static void donate_to_holders(struct thread *, tid_t donor, int depth);
+static void mlfqs_update_second(void);
+static softirq_func sched_softirq;
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -106,6 +219,10 @@ static uint64_t gdt[3] = {0, 0x00af9a000000ffff, 0x00cf92000000ffff};
 void thread_init(void)
 {
 	ASSERT(intr_get_level() == INTR_OFF); // Intr가 disabld 상태인지 확인, 꺼져있으면 thread init을 실행시킨다.
+	cpu_init();
+	softirq_register(SOFTIRQ_SCHED, sched_softirq, "sched");
+	if (thread_mlfqs && thread_cfs)
+		PANIC("-mlfqs and -cfs cannot be used together");
 
 	/* Reload the temporal gdt for the kernel
 	 * This gdt does not include the user context.
@@ -116,17 +233,20 @@ void thread_init(void)
 	lgdt(&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init(&tid_lock);		 // tid 생성기에 접근,, 한명만 들어올 수 있도록. 다른 스레드가 들어오지 못하도록 자물쇠는 거는것. 임계영역= 다른 스레드가 접근하면 안되는 곳. 한번에 여러 스레드가 접근하면 안되기때문에
-	list_init(&ready_list);		 // 레디큐초기화
-	list_init(&sleep_list);		 // 슬립 리스트 초기화
+	spin_init(&tid_lock);		 // tid 생성기에 접근,, 한명만 들어올 수 있도록. 다른 스레드가 들어오지 못하도록 자물쇠는 거는것. 임계영역= 다른 스레드가 접근하면 안되는 곳. 한번에 여러 스레드가 접근하면 안되기때문에
+	for (int i = 0; i < cpu_cnt; i++)
+		rq_init(&cpus[i].rq); // CPU별 레디큐 초기화
+	list_init(&all_list);
 	list_init(&wait_list);		 // lock 대기 리스트 초기화
 	list_init(&destruction_req); // 파괴요청이 들어오는 스레드들 을 집어넣는 리스트
+	sema_init(&reap_sema, 0);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread(); // 현재 돌아가고있는 스레드의 구조체가 저장될 주를 반환 받음.
 	// running thread함수 => 그림에서 밑에 부분의 밑으ㅏㅣ부분...
 	init_thread(initial_thread, "main", PRI_DEFAULT); // 쓰레드가 초기화 됨. 이름을 main으로
-	initial_thread->status = THREAD_RUNNING;		  // 쓰레드상태를 러닝으로 바꿈 초기상태:blocked. 아직 돌아가는 상태는 아님
+	initial_thread->status = THREAD_RUNNING;
+	cpu_current()->curr = initial_thread;		  // 쓰레드상태를 러닝으로 바꿈 초기상태:blocked. 아직 돌아가는 상태는 아님
 	initial_thread->tid = allocate_tid();			  // tid 부여받음. 쓰레드의 아이디값.
 }
 
@@ -148,37 +268,185 @@ void thread_start(void)
 	// 선점이면 비킬 수 있다.
 	// context switching
 
-	/* Wait for the idle thread to initialize idle_thread. */
+	/* Wait for the idle thread to initialize cpu->idle_thread. */
 	sema_down(&idle_started);
 	// 초기화 되기전에 다음꺼 실행할 수 없어서,, 이렇게 세마포어를 사용했다.
+
+	/* Create the reaper, which frees the pages of dead threads
+	   outside of the scheduler. */
+	thread_create("reaper", PRI_MAX, reaper, NULL);
 }
 
 /* Called by the timer interrupt handler at each timer tick.
    Thus, this function runs in an external interrupt context. */
 void thread_tick(void)
 {
+	struct cpu *c = cpu_current();
 	struct thread *t = thread_current();
+	struct thread *idle_thread = c->idle_thread;
 
 	/* Update statistics. */
 	if (t == idle_thread)
-		idle_ticks++; // 맨처음 스레드 생성햇을때 가장 먼저 생성된것. 아이들 = 스ㄹㅔ드 = 공회전
+		c->idle_ticks++; // 맨처음 스레드 생성햇을때 가장 먼저 생성된것. 아이들 = 스ㄹㅔ드 = 공회전
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++; // main
+		c->kernel_ticks++; // main
+
+	/* Update the MLFQS.  Only the running thread's recent_cpu
+	   changes between once-per-second recalculations, so only
+	   its priority needs to be recomputed every fourth tick. */
+	if (thread_mlfqs)
+	{
+		int64_t now = timer_ticks();
+		if (t != idle_thread)
+			t->recent_cpu = fp_add_int(t->recent_cpu, 1);
+		if (now % TIMER_FREQ == 0)
+			softirq_raise(SOFTIRQ_SCHED);
+		else if (now % 4 == 0 && t != idle_thread)
+			t->priority = mlfqs_priority(t);
+		test_max_priority();
+	}
+
+	/* Charge the running thread for its tick of CPU time. */
+	if (thread_is_edf(t))
+		edf_charge(t);
+	else if (thread_cfs && t != idle_thread)
+	{
+		t->vruntime += NICE_0_WEIGHT * NICE_0_WEIGHT / cfs_weight(t);
+		cfs_update_min_vruntime(t);
+	}
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++c->thread_ticks >= thread_timeslice(t))
 		intr_yield_on_return();
 }
 
-/* Prints thread statistics. */
+/* Prints thread statistics: totals, then a line per CPU. */
 void thread_print_stats(void)
 {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++)
+	{
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+	}
 	printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 		   idle_ticks, kernel_ticks, user_ticks);
+	printf("Thread pages: %lld recycled, %lld allocated\n",
+		   pages_recycled, pages_allocated);
+	for (i = 0; i < cpu_cnt; i++)
+		printf("CPU %d: %lld idle ticks, %lld kernel ticks, %lld user ticks, "
+			   "%lld idle wakeups\n",
+			   i, cpus[i].idle_ticks, cpus[i].kernel_ticks, cpus[i].user_ticks,
+			   cpus[i].idle_wakeups);
+#ifdef LOCK_STAT
+	lock_stat_print();
+#endif
+}
+
+/* A copy of one thread's wakeup latency histogram. */
+struct latency_snap
+{
+	tid_t tid;
+	char name[16];
+	unsigned hist[LATENCY_BUCKETS];
+};
+
+/* Prints the wakeup latency histogram of all threads, then that
+   of each live thread that has been woken up.  The histograms
+   are copied with interrupts off, so that threads may exit while
+   they are printed, into a page that holds as many threads as
+   fit. */
+void thread_print_latency(void)
+{
+	struct latency_snap *snaps = palloc_get_page(0);
+	size_t snap_max = PGSIZE / sizeof *snaps - 1;
+	size_t snap_cnt = 0, skipped = 0, i;
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	if (snaps == NULL)
+		return;
+
+	old_level = intr_disable();
+	strlcpy(snaps[0].name, "all", sizeof snaps[0].name);
+	memcpy(snaps[0].hist, latency_hist, sizeof latency_hist);
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, allelem);
+		bool woken = false;
+
+		for (i = 0; i < LATENCY_BUCKETS; i++)
+			woken |= t->latency_hist[i] != 0;
+		if (!woken)
+			continue;
+		if (snap_cnt == snap_max)
+		{
+			skipped++;
+			continue;
+		}
+		snap_cnt++;
+		snaps[snap_cnt].tid = t->tid;
+		strlcpy(snaps[snap_cnt].name, t->name, sizeof snaps[snap_cnt].name);
+		memcpy(snaps[snap_cnt].hist, t->latency_hist, sizeof t->latency_hist);
+	}
+	intr_set_level(old_level);
+
+	printf("Wakeup latency, log2 TSC cycles: count\n");
+	latency_print_hist("all", snaps[0].hist);
+	for (i = 1; i <= snap_cnt; i++)
+	{
+		char name[32];
+
+		snprintf(name, sizeof name, "%s (%d)", snaps[i].name, snaps[i].tid);
+		latency_print_hist(name, snaps[i].hist);
+	}
+	if (skipped > 0)
+		printf("  (%zu more threads)\n", skipped);
+	palloc_free_page(snaps);
+}
+
+/* Prints HIST on one line, labelled NAME, leaving out empty
+   buckets. */
+static void
+latency_print_hist(const char *name, const unsigned hist[])
+{
+	int i;
+
+	printf("  %-20s", name);
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+		if (hist[i] != 0)
+			printf(" %d:%u", i, hist[i]);
+	printf("\n");
+}
+
+/* Charges the time NEXT spent between being woken up and being
+   switched to, if it was woken up, to NEXT's and the global
+   wakeup latency histograms.  Called by schedule(). */
+static void
+latency_record(struct thread *next)
+{
+	uint64_t latency;
+	int bucket = 0;
+
+	if (next->wakeup_tsc == 0)
+		return;
+	latency = rdtsc() - next->wakeup_tsc;
+	next->wakeup_tsc = 0;
+
+	while (latency > 1 && bucket < LATENCY_BUCKETS - 1)
+	{
+		latency >>= 1;
+		bucket++;
+	}
+	next->latency_hist[bucket]++;
+	latency_hist[bucket]++;
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -206,7 +474,7 @@ tid_t thread_create(const char *name, int priority,
 	ASSERT(function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page(PAL_ZERO); // 페이지를 할당받아서 스레드에 가리키게 만든다.
+	t = thread_page_get(); // 페이지를 할당받아서 스레드에 가리키게 만든다.
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -214,6 +482,19 @@ tid_t thread_create(const char *name, int priority,
 	init_thread(t, name, priority);
 	tid = t->tid = allocate_tid();
 
+	/* Under the MLFQS, the new thread inherits its parent's
+	   niceness and recent_cpu, and PRIORITY is ignored. */
+	if (thread_mlfqs)
+	{
+		t->nice = thread_current()->nice;
+		t->recent_cpu = thread_current()->recent_cpu;
+		t->priority = t->init_priority = mlfqs_priority(t);
+	}
+
+	/* Under the CFS, a new thread starts level with the threads
+	   that have run the least. */
+	t->vruntime = cpu_current()->rq.cfs_min_vruntime;
+
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	// Tf = 스위칭할때 필요한것
@@ -252,6 +533,7 @@ void thread_block(void)
 {
 	ASSERT(!intr_context());
 	ASSERT(intr_get_level() == INTR_OFF);
+	trace_event(TRACE_BLOCK, thread_current(), 0);
 	thread_current()->status = THREAD_BLOCKED;
 	schedule();
 }
@@ -272,10 +554,15 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable(); // 인터럽트 비활성화 시키기. 다른 인터럽트가 발생하면 안되므로.
 	ASSERT(t->status == THREAD_BLOCKED);
-	// list_push_back (&ready_list, &t->elem);
-	// 언블록할때 readylist에 넣을때는 우선순위 순으로 넣어야 한다.
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
+	// 언블록할때 자기 우선순위의 레디큐 맨 뒤에 넣는다. O(1)
+	if (thread_is_edf(t))
+		edf_place(t);
+	else if (thread_cfs)
+		cfs_place(t);
+	ready_push(t);
 	t->status = THREAD_READY;  // 레디 상태로 만들어주기.
+	t->wakeup_tsc = rdtsc();
+	trace_event(TRACE_UNBLOCK, t, intr_context() ? -1 : thread_current()->tid);
 	intr_set_level(old_level); // 이전 상태로 만들어줌.
 }
 
@@ -323,7 +610,15 @@ void thread_exit(void)
 
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
+	/* Our page joins destruction_req once we switch away.  Past
+	   the cache's limit, have the reaper trim it. */
+	if (destruction_cnt >= THREAD_CACHE_MAX)
+		sema_up(&reap_sema);
+
 	intr_disable();
+	list_remove(&thread_current()->allelem);
+	timer_cancel(&thread_current()->dl_timer);
+	dl_total_bw -= thread_current()->dl_bw;
 	do_schedule(THREAD_DYING);
 	NOT_REACHED();
 }
@@ -340,64 +635,96 @@ void thread_yield(void)
 	ASSERT(!intr_context());
 
 	old_level = intr_disable(); // 인터럽트 비활성화. 올드레벨은 이전 상태를 받아옴
-	if (curr != idle_thread)	// 현재 스레드가 아이들 스레드 아닐때, 레디 중인 스레드가 없다.
-		// list_push_back (&ready_list, &curr->elem);  // 레디큐에 넣는다.
-		list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
+	if (!thread_is_idle(curr))	// 현재 스레드가 아이들 스레드 아닐때, 레디 중인 스레드가 없다.
+		ready_push(curr);		// 자기 우선순위의 레디큐에 넣는다.
 	do_schedule(THREAD_READY); // 뺏기는 과정. 현재 러닝중인 스레들을 인자로 넣어준 것으로 바꾸고, 레드큐에 있던걸 러닝 쓰레드로 바꿔줌. 현재 러닝 스레드를 레디큐에 넣어주기 위해서 레디라는 상태로 넣어줌 . 양보당하는애가 레디 상태로 되고, 두 스케줄 함수 = 현재 러닝중인 쓰레드를 인자로 넣어준 상태로 바꾸고 레디큐에 있는것을 러닝 스레드로 바꾼다
 	intr_set_level(old_level);
 }
 
-// 잠든 스레드를 sleep_list에 삽입하는 함수
-//  sleep_list에 ticks가 작은 스레드가 앞부분에 위치하도록 정렬하여 삽입한다.
+// 현재 스레드를 WAKE_TICK 까지 재운다.
+// 스레드마다 가진 sleep_timer 를 타이머 휠에 등록하고 블락한다. O(1)
 void thread_sleep(int64_t wake_tick)
 {
 	struct thread *curr = thread_current();
 	enum intr_level old_level;
 	ASSERT(!intr_context());
 	old_level = intr_disable();
-	if (curr != idle_thread)
+	if (!thread_is_idle(curr))
 	{
 		// 이시간에 일어나렴
-		curr->wakeup_tick = wake_tick;
-		list_insert_ordered(&sleep_list, &curr->elem, cmp_thread_ticks, NULL);
-		// 리스트 푸시백
-		// 레디리스트는 우선순위 정렬이 안되어있어서 뒤에 푸시한다.
+		timer_add(&curr->sleep_timer, wake_tick, thread_wake, curr);
+		do_schedule(THREAD_BLOCKED);
 	}
-
-	do_schedule(THREAD_BLOCKED);
 	intr_set_level(old_level);
 }
 
-void thread_wake(int64_t elapsed)
+/* Timer callback that wakes up sleeping thread T_.  Runs in the
+   timer interrupt, so a woken thread with higher priority than
+   the interrupted one preempts it on interrupt return. */
+static void
+thread_wake(void *t_)
+{
+	struct thread *t = t_;
+	thread_unblock(t);
+	test_max_priority();
+}
+
+/* Makes the current thread an EDF thread that is guaranteed
+   RUNTIME ticks of CPU time in every PERIOD ticks, starting now.
+   The thread's relative deadline equals its period.  RUNTIME of
+   0 returns the thread to its ordinary scheduling class.
+
+   Returns false, leaving the thread unchanged, if the arguments
+   are invalid, PERIOD is over DL_PERIOD_MAX, or admitting the
+   reservation would raise the total EDF utilization above
+   thread_edf_bound percent.  A reservation's bandwidth is
+   rounded up, so that even the smallest one counts. */
+bool thread_set_deadline(int64_t runtime, int64_t period)
 {
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	uint64_t bw = 0;
 
-	while (!list_empty(&sleep_list) && list_entry(list_front(&sleep_list), struct thread, elem)->wakeup_tick <= elapsed)
+	if (runtime < 0 || (runtime > 0 && (period <= 0 || runtime > period
+										|| period > DL_PERIOD_MAX)))
+		return false;
+	if (runtime > 0)
+		bw = (((uint64_t)runtime << DL_BW_SHIFT) + period - 1) / period;
+
+	old_level = intr_disable();
+	if (dl_total_bw - curr->dl_bw + bw > ((uint64_t)thread_edf_bound << DL_BW_SHIFT) / 100)
 	{
-		struct list_elem *front_elem = list_pop_front(&sleep_list);
-		thread_unblock(list_entry(front_elem, struct thread, elem));
+		intr_set_level(old_level);
+		return false;
 	}
+	dl_total_bw = dl_total_bw - curr->dl_bw + bw;
+	curr->dl_bw = bw;
+
+	timer_cancel(&curr->dl_timer);
+	curr->dl_throttled = false;
+	curr->dl_runtime = curr->dl_budget = runtime;
+	curr->dl_period = runtime > 0 ? period : 0;
+	curr->dl_deadline = timer_ticks() + curr->dl_period;
+	intr_set_level(old_level);
+
+	test_max_priority();
+	return true;
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void thread_set_priority(int new_priority)
 {
 	struct thread *curr = thread_current();
-	if (list_empty(&curr->donators))
-	{
-		curr->init_priority = new_priority;
-		curr->priority = new_priority;
-	}
-	else
-	{
-		curr->priority = list_entry(list_max(&curr->donators, cmp_dpriority, NULL), struct thread, d_elem)->priority;
-		curr->init_priority = new_priority;
-	}
-	// refresh_priority();
-	// if (thread_current()->wait_on_lock != NULL)
-	// {
+	enum intr_level old_level;
+
+	/* The MLFQS computes priorities itself. */
+	if (thread_mlfqs)
+		return;
 
-	// 	priority_donate();
-	// }
+	old_level = intr_disable();
+	curr->init_priority = new_priority;
+	refresh_priority();
+	intr_set_level(old_level);
 	test_max_priority();
 }
 
@@ -407,31 +734,98 @@ int thread_get_priority(void)
 	return (thread_current())->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED)
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest
+   priority. */
+void thread_set_nice(int nice)
 {
-	/* TODO: Your implementation goes here */
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable();
+	curr->nice = nice;
+	if (thread_mlfqs)
+		curr->priority = mlfqs_priority(curr);
+	intr_set_level(old_level);
+	test_max_priority();
 }
 
 /* Returns the current thread's nice value. */
 int thread_get_nice(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int thread_get_load_avg(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable();
+	int load_avg_100 = fp_to_int_round(load_avg * 100);
+	intr_set_level(old_level);
+	return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int thread_get_recent_cpu(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable();
+	int recent_cpu_100 = fp_to_int_round(thread_current()->recent_cpu * 100);
+	intr_set_level(old_level);
+	return recent_cpu_100;
+}
+
+/* Returns the MLFQS priority of T,
+   PRI_MAX - recent_cpu / 4 - nice * 2, clamped to the valid
+   range. */
+static int
+mlfqs_priority(const struct thread *t)
+{
+	int priority = PRI_MAX - fp_to_int(t->recent_cpu / 4) - t->nice * 2;
+	if (priority < PRI_MIN)
+		return PRI_MIN;
+	if (priority > PRI_MAX)
+		return PRI_MAX;
+	return priority;
+}
+
+/* Scheduler softirq, raised by thread_tick() once a second
+   under the MLFQS.  The recalculation visits every thread, so it
+   runs here rather than in the timer interrupt itself. */
+static void
+sched_softirq(void)
+{
+	enum intr_level old_level = intr_disable();
+	mlfqs_update_second();
+	test_max_priority();
+	intr_set_level(old_level);
+}
+
+/* Once-per-second MLFQS recalculation: updates the load
+   average, then decays every thread's recent_cpu and recomputes
+   its priority.  Ready threads move to the run queue for their
+   new priority in O(1) each. */
+static void
+mlfqs_update_second(void)
+{
+	fixed_t twice_load, decay;
+	struct list_elem *e;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	load_avg = fp_mul(fp_div(int_to_fp(59), int_to_fp(60)), load_avg) + int_to_fp(ready_threads()) / 60;
+
+	twice_load = load_avg * 2;
+	decay = fp_div(twice_load, fp_add_int(twice_load, 1));
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, allelem);
+		if (thread_is_idle(t))
+			continue;
+		t->recent_cpu = fp_add_int(fp_mul(decay, t->recent_cpu), t->nice);
+		thread_update_priority(t, mlfqs_priority(t));
+	}
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -447,7 +841,7 @@ static void
 idle(void *idle_started_ UNUSED)
 {
 	struct semaphore *idle_started = idle_started_;
-	idle_thread = thread_current();
+	cpu_current()->idle_thread = thread_current();
 	sema_up(idle_started); //
 
 	for (;;)
@@ -467,9 +861,78 @@ idle(void *idle_started_ UNUSED)
 		   time.
 
 		   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-		   7.11.1 "HLT Instruction". */
+		   7.11.1 "HLT Instruction".
+
+		   In tickless mode, timer_idle_enter() first stops the
+		   periodic tick until the next timer deadline, so that we
+		   only wake up when there is work to do. */
+		timer_idle_enter();
 		asm volatile("sti; hlt" : : : "memory");
+		cpu_current()->idle_wakeups++;
+	}
+}
+
+/* Reaper thread.  Frees the pages of dead threads that the
+   cache in destruction_req has no room for, in batches, so that
+   neither schedule() nor thread_exit() has to call palloc. */
+static void
+reaper(void *aux UNUSED)
+{
+	for (;;)
+	{
+		sema_down(&reap_sema);
+		for (;;)
+		{
+			struct thread *victim = NULL;
+			enum intr_level old_level = intr_disable();
+
+			/* Trim to half the limit, so that we are not woken by
+			   every exit while many threads come and go. */
+			if (destruction_cnt > THREAD_CACHE_MAX / 2)
+			{
+				victim = list_entry(list_pop_front(&destruction_req),
+									struct thread, elem);
+				destruction_cnt--;
+			}
+			intr_set_level(old_level);
+			if (victim == NULL)
+				break;
+			palloc_free_page(victim);
+		}
+	}
+}
+
+/* Returns a page for a new thread: the most recently freed page
+   in destruction_req, which is likely still in the cache, or a
+   fresh one from palloc.  Neither is zeroed, since init_thread()
+   clears the struct thread and the stack needs no clearing.
+   Returns a null pointer if memory is exhausted.
+
+   A page is added to destruction_req just before its thread
+   switches away for the last time, with interrupts off, so by
+   the time another thread runs here the page is no longer in
+   use. */
+static struct thread *
+thread_page_get(void)
+{
+	struct thread *t = NULL;
+	enum intr_level old_level = intr_disable();
+
+	if (!list_empty(&destruction_req))
+	{
+		t = list_entry(list_pop_back(&destruction_req), struct thread, elem);
+		destruction_cnt--;
+		pages_recycled++;
+	}
+	intr_set_level(old_level);
+
+	if (t == NULL)
+	{
+		t = palloc_get_page(0);
+		if (t != NULL)
+			pages_allocated++;
 	}
+	return t;
 }
 
 /* Function used as the basis for a kernel thread. */
@@ -488,6 +951,8 @@ kernel_thread(thread_func *function, void *aux)
 static void
 init_thread(struct thread *t, const char *name, int priority)
 {
+	enum intr_level old_level;
+
 	ASSERT(t != NULL);
 	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT(name != NULL);
@@ -501,7 +966,23 @@ init_thread(struct thread *t, const char *name, int priority)
 
 	t->init_priority = priority;
 	t->wait_on_lock = NULL;
-	list_init(&t->donators);
+	t->wait_on_rw = NULL;
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+		t->rw_holds[i].rw = NULL;
+	t->waitq = NULL;
+	pheap_init(&t->held_locks, held_lock_less, NULL);
+#ifdef USERPROG
+	list_init(&t->user_threads);
+	lock_init(&t->user_threads_lock);
+	cond_init(&t->user_threads_done);
+#endif
+
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = 0;
+	t->cpu = cpu_current();
+	old_level = intr_disable();
+	list_push_back(&all_list, &t->allelem);
+	intr_set_level(old_level);
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -514,10 +995,385 @@ init_thread(struct thread *t, const char *name, int priority)
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
-		return idle_thread;
+	struct cpu *c = cpu_current();
+	struct thread *t = ready_pop();
+
+	if (t == NULL)
+		t = c->idle_thread;
+	t->cpu = c;
+	return t;
+}
+
+/* Initializes RQ as an empty run queue. */
+static void
+rq_init(struct runqueue *rq)
+{
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init(&rq->ready_queues[pri]); // 우선순위별 레디큐 초기화
+	rq->ready_mask = 0;
+	rq->ready_cnt = 0;
+	rb_init(&rq->cfs_queue, cfs_less, NULL);
+	rq->cfs_load = 0;
+	rq->cfs_min_vruntime = 0;
+	rb_init(&rq->dl_queue, edf_less, NULL);
+}
+
+/* Adds T to RQ: to the back of the queue for its priority, or
+   under the CFS, to the tree in order of virtual runtime.  EDF
+   threads go to the deadline tree regardless of the scheduler. */
+static void
+rq_push(struct runqueue *rq, struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (thread_is_edf(t))
+		rb_insert(&rq->dl_queue, &t->dl_node);
+	else if (thread_cfs)
+	{
+		rb_insert(&rq->cfs_queue, &t->run_node);
+		rq->cfs_load += cfs_weight(t);
+	}
 	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+	{
+		list_push_back(&rq->ready_queues[t->priority], &t->elem);
+		rq->ready_mask |= 1ULL << t->priority;
+	}
+	rq->ready_cnt++;
+}
+
+/* Removes and returns the EDF thread in RQ with the earliest
+   deadline, or if there is none, the first thread in the
+   highest-priority nonempty queue.  Returns a null pointer if
+   RQ is empty. */
+static struct thread *
+rq_pop(struct runqueue *rq)
+{
+	struct list *queue;
+	struct thread *t;
+	int pri;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (!rb_empty(&rq->dl_queue))
+	{
+		t = rb_entry(rb_min(&rq->dl_queue), struct thread, dl_node);
+		rb_remove(&rq->dl_queue, &t->dl_node);
+		rq->ready_cnt--;
+		return t;
+	}
+	if (thread_cfs)
+	{
+		struct rb_elem *e = rb_min(&rq->cfs_queue);
+		if (e == NULL)
+			return NULL;
+		t = rb_entry(e, struct thread, run_node);
+		rb_remove(&rq->cfs_queue, e);
+		rq->cfs_load -= cfs_weight(t);
+		rq->ready_cnt--;
+		return t;
+	}
+	if (rq->ready_mask == 0)
+		return NULL;
+
+	pri = 63 - __builtin_clzll(rq->ready_mask);
+	queue = &rq->ready_queues[pri];
+	t = list_entry(list_pop_front(queue), struct thread, elem);
+	if (list_empty(queue))
+		rq->ready_mask &= ~(1ULL << pri);
+	rq->ready_cnt--;
+	return t;
+}
+
+/* Adds T to the run queue of the current CPU. */
+static void
+ready_push(struct thread *t)
+{
+	t->cpu = cpu_current();
+	rq_push(&t->cpu->rq, t);
+}
+
+/* Removes and returns the next thread to run from the current
+   CPU's run queue.  Returns a null pointer if it is empty. */
+static struct thread *
+ready_pop(void)
+{
+	return rq_pop(&cpu_current()->rq);
+}
+
+/* Removes ready thread T from its run queue.  T->priority and
+   T's scheduling class must still be the ones it was queued
+   with. */
+static void
+ready_remove(struct thread *t)
+{
+	struct runqueue *rq = &t->cpu->rq;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(t->status == THREAD_READY);
+	if (thread_is_edf(t))
+		rb_remove(&rq->dl_queue, &t->dl_node);
+	else if (thread_cfs)
+	{
+		rb_remove(&rq->cfs_queue, &t->run_node);
+		rq->cfs_load -= cfs_weight(t);
+	}
+	else
+	{
+		list_remove(&t->elem);
+		if (list_empty(&rq->ready_queues[t->priority]))
+			rq->ready_mask &= ~(1ULL << t->priority);
+	}
+	rq->ready_cnt--;
+}
+
+/* Returns the priority of the highest-priority thread ready on
+   the current CPU, or PRI_MIN - 1 if no thread is ready. */
+static int
+ready_max_priority(void)
+{
+	uint64_t mask = cpu_current()->rq.ready_mask;
+
+	if (mask == 0)
+		return PRI_MIN - 1;
+	return 63 - __builtin_clzll(mask);
+}
+
+/* Returns the number of threads that are running or ready to
+   run, not counting idle threads. */
+static int
+ready_threads(void)
+{
+	int cnt = 0;
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++)
+	{
+		cnt += cpus[i].rq.ready_cnt;
+		if (cpus[i].curr != NULL && !thread_is_idle(cpus[i].curr))
+			cnt++;
+	}
+	return cnt;
+}
+
+/* Returns true if T is the idle thread of some CPU. */
+static bool
+thread_is_idle(const struct thread *t)
+{
+	return t == t->cpu->idle_thread;
+}
+
+/* Sets the time slice of priorities LO through HI, inclusive, to
+   TICKS timer ticks.  Applies to the priority scheduler and the
+   MLFQS; the CFS and EDF classes size their slices themselves.
+   Takes effect at the next time slice. */
+void thread_set_timeslice(int lo, int hi, unsigned ticks)
+{
+	int pri;
+
+	ASSERT(PRI_MIN <= lo && lo <= hi && hi <= PRI_MAX);
+	ASSERT(ticks > 0);
+
+	for (pri = lo; pri <= hi; pri++)
+		time_slices[pri] = ticks;
+}
+
+/* Returns the time slice of PRIORITY, in timer ticks. */
+unsigned
+thread_get_timeslice(int priority)
+{
+	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+	return time_slices[priority] != 0 ? time_slices[priority] : TIME_SLICE;
+}
+
+/* Returns the number of ticks T may run before it is preempted.
+   The CFS divides CFS_LATENCY among the ready threads in
+   proportion to their weights, so that slices shrink as the run
+   queue grows, down to CFS_MIN_GRANULARITY.  EDF threads have
+   no time slice: they run until they block, use up their
+   budget, or are preempted by an earlier deadline. */
+static unsigned
+thread_timeslice(struct thread *t)
+{
+	struct runqueue *rq = &cpu_current()->rq;
+	unsigned weight, period, slice;
+
+	if (thread_is_edf(t))
+		return UINT_MAX;
+	if (thread_is_idle(t))
+		return TIME_SLICE;
+	if (!thread_cfs)
+		return thread_get_timeslice(t->priority);
+
+	weight = cfs_weight(t);
+	period = CFS_LATENCY;
+	if ((unsigned)rq->ready_cnt + 1 > CFS_LATENCY / CFS_MIN_GRANULARITY)
+		period = (rq->ready_cnt + 1) * CFS_MIN_GRANULARITY;
+	slice = (uint64_t)period * weight / (rq->cfs_load + weight);
+	return slice > CFS_MIN_GRANULARITY ? slice : CFS_MIN_GRANULARITY;
+}
+
+/* Orders threads in rq->cfs_queue by virtual runtime. */
+static bool
+cfs_less(const struct rb_elem *a_, const struct rb_elem *b_, void *aux UNUSED)
+{
+	const struct thread *a = rb_entry(a_, struct thread, run_node);
+	const struct thread *b = rb_entry(b_, struct thread, run_node);
+	return a->vruntime < b->vruntime;
+}
+
+/* Returns T's CFS weight, which depends on its niceness. */
+static unsigned
+cfs_weight(const struct thread *t)
+{
+	return cfs_nice_to_weight[t->nice - NICE_MIN];
+}
+
+/* Places woken thread T in virtual time on the current CPU.  A
+   thread that slept keeps its vruntime, but no further back than
+   half a latency period behind the threads that have run the
+   least, so that a long sleep does not buy it a long monopoly on
+   the CPU. */
+static void
+cfs_place(struct thread *t)
+{
+	int64_t floor = cpu_current()->rq.cfs_min_vruntime - CFS_LATENCY * NICE_0_WEIGHT / 2;
+	if (t->vruntime < floor)
+		t->vruntime = floor;
+}
+
+/* Advances the current CPU's cfs_min_vruntime to the smallest
+   vruntime among the running thread CURR and the ready threads. */
+static void
+cfs_update_min_vruntime(struct thread *curr)
+{
+	struct runqueue *rq = &cpu_current()->rq;
+	struct rb_elem *e = rb_min(&rq->cfs_queue);
+	int64_t v = curr->vruntime;
+
+	if (e != NULL && rb_entry(e, struct thread, run_node)->vruntime < v)
+		v = rb_entry(e, struct thread, run_node)->vruntime;
+	if (v > rq->cfs_min_vruntime)
+		rq->cfs_min_vruntime = v;
+}
+
+/* Returns true if the leftmost ready thread is far enough
+   behind running thread CURR in virtual time to preempt it. */
+static bool
+cfs_should_preempt(struct thread *curr)
+{
+	struct rb_elem *e = rb_min(&cpu_current()->rq.cfs_queue);
+
+	if (e == NULL)
+		return false;
+	if (thread_is_idle(curr))
+		return true;
+	return curr->vruntime - rb_entry(e, struct thread, run_node)->vruntime > CFS_WAKEUP_GRANULARITY;
+}
+
+/* Orders threads in rq->dl_queue by absolute deadline. */
+static bool
+edf_less(const struct rb_elem *a_, const struct rb_elem *b_, void *aux UNUSED)
+{
+	const struct thread *a = rb_entry(a_, struct thread, dl_node);
+	const struct thread *b = rb_entry(b_, struct thread, dl_node);
+	return a->dl_deadline < b->dl_deadline;
+}
+
+/* Returns true if T is currently scheduled by the EDF class,
+   that is, it has a reservation and has not used up the budget
+   for its current period. */
+static bool
+thread_is_edf(const struct thread *t)
+{
+	return t->dl_period != 0 && !t->dl_throttled;
+}
+
+/* Applies the constant bandwidth server wakeup rule to EDF
+   thread T.  If T's remaining budget could not be used up
+   before its current deadline without exceeding its reserved
+   bandwidth, it gets a fresh budget and deadline instead. */
+static void
+edf_place(struct thread *t)
+{
+	int64_t now = timer_ticks();
+
+	if (t->dl_deadline <= now
+		|| t->dl_budget * t->dl_period > (t->dl_deadline - now) * t->dl_runtime)
+	{
+		t->dl_budget = t->dl_runtime;
+		t->dl_deadline = now + t->dl_period;
+	}
+}
+
+/* Charges running EDF thread T for one tick.  When its budget
+   runs out, T is throttled: it drops to its ordinary scheduling
+   class until its deadline, when edf_replenish() restores its
+   budget for the next period.  This keeps an overrunning thread
+   from eating into the bandwidth reserved by the others. */
+static void
+edf_charge(struct thread *t)
+{
+	int64_t now = timer_ticks();
+
+	if (--t->dl_budget > 0)
+		return;
+
+	if (t->dl_deadline <= now)
+	{
+		/* Already late, so there is nothing to wait for. */
+		t->dl_budget = t->dl_runtime;
+		t->dl_deadline = now + t->dl_period;
+	}
+	else
+	{
+		t->dl_throttled = true;
+		timer_add(&t->dl_timer, t->dl_deadline, edf_replenish, t);
+		if (thread_cfs)
+			cfs_place(t);
+	}
+	intr_yield_on_return();
+}
+
+/* Timer callback that gives throttled EDF thread T_ a fresh
+   budget at the start of its next period. */
+static void
+edf_replenish(void *t_)
+{
+	struct thread *t = t_;
+	bool ready = t->status == THREAD_READY;
+
+	if (ready)
+		ready_remove(t);
+	t->dl_throttled = false;
+	t->dl_budget = t->dl_runtime;
+	t->dl_deadline += t->dl_period;
+	if (ready)
+		rq_push(&t->cpu->rq, t);
+	test_max_priority();
+}
+
+/* Sets T's effective priority to PRIORITY.  If T is waiting in
+   the run queue, it is moved to the queue for its new priority
+   so that the run queue stays consistent, and if it is waiting
+   in a semaphore's or condition variable's queue, it is re-keyed
+   there. */
+void thread_update_priority(struct thread *t, int priority)
+{
+	enum intr_level old_level;
+
+	ASSERT(is_thread(t));
+	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+	old_level = intr_disable();
+	if (t->status == THREAD_READY && t->priority != priority && !thread_cfs)
+	{
+		ready_remove(t);
+		t->priority = priority;
+		rq_push(&t->cpu->rq, t);
+	}
+	else
+		t->priority = priority;
+	if (t->waitq != NULL)
+		pq_rekey(t->waitq, t->waitq_elem, priority);
+	intr_set_level(old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -544,6 +1400,10 @@ void do_iret(struct intr_frame *tf)
 		"movw 8(%%rsp),%%ds\n"
 		"movw (%%rsp),%%es\n"
 		"addq $32, %%rsp\n"
+		"testb $3, 8(%%rsp)\n" // Entering user mode?
+		"jz 1f\n"
+		"swapgs\n"
+		"1:\n"
 		"iretq"
 		: : "g"((uint64_t)tf) : "memory");
 }
@@ -626,12 +1486,6 @@ do_schedule(int status)
 {
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(thread_current()->status == THREAD_RUNNING);
-	while (!list_empty(&destruction_req))
-	{ // 레디큐가 빌때까지
-		struct thread *victim =
-			list_entry(list_pop_front(&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
-	}
 
 	thread_current()->status = status;
 	schedule();
@@ -649,10 +1503,12 @@ schedule(void)
 	ASSERT(is_thread(next));
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	next->cpu->curr = next;
+	latency_record(next);
 
 	/* Start new time slice. */
 	// tick = 시간 얼마나 썼나 ? 다음으로 넘어갔으니까.
-	thread_ticks = 0;
+	next->cpu->thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -661,18 +1517,21 @@ schedule(void)
 
 	if (curr != next)
 	{
+		trace_event(TRACE_SWITCH, curr, next->tid);
+
 		/* If the thread we switched from is dying, destroy its struct
 		   thread. This must happen late so that thread_exit() doesn't
 		   pull out the rug under itself.
 		   We just queuing the page free reqeust here because the page is
 		   currently used by the stack.
-		   The real destruction logic will be called at the beginning of the
-		   schedule(). */
+		   thread_create() later recycles the page, or the reaper frees
+		   it. */
 		// 죽었다고 마킹한 스레드들이 모여있는 곳으로 보낸다.
 		if (curr && curr->status == THREAD_DYING && curr != initial_thread)
 		{ // initial thred = main thread
 			ASSERT(curr != next);
 			list_push_back(&destruction_req, &curr->elem);
+			destruction_cnt++;
 		}
 
 		/* Before switching the thread, we first save the information
@@ -688,125 +1547,190 @@ allocate_tid(void)
 	static tid_t next_tid = 1;
 	tid_t tid;
 
-	lock_acquire(&tid_lock);
+	spin_lock(&tid_lock);
 	tid = next_tid++;
-	lock_release(&tid_lock);
+	spin_unlock(&tid_lock);
 
 	return tid;
 }
 
-bool cmp_thread_ticks(struct list_elem *a_, struct list_elem *b_, void *aux UNUSED)
+// 현재 수행중인 스레드와 가장 높은 우선순위의 스레드를 우선비교하여 스케줄링
+// 레디큐의 최고 우선순위는 ready_mask 에서 바로 구한다. O(1)
+// 인터럽트 핸들러 안에서(예: sema_up) 불리면 리턴할 때 양보하도록 한다.
+void test_max_priority(void)
+{
+	struct thread *curr = thread_current();
+	struct rb_elem *e = rb_min(&cpu_current()->rq.dl_queue);
+	bool preempt;
+
+	if (e != NULL && (!thread_is_edf(curr)
+					  || rb_entry(e, struct thread, dl_node)->dl_deadline < curr->dl_deadline))
+		preempt = true;
+	else if (thread_is_edf(curr))
+		preempt = false;
+	else
+		preempt = thread_cfs ? cfs_should_preempt(curr)
+							 : curr->priority < ready_max_priority();
+	if (preempt)
+	{
+		if (intr_context())
+			intr_yield_on_return();
+		else
+			thread_yield();
+	}
+}
+
+/* Returns the priority that HOLD donates to its holder: that of
+   its highest-priority waiter, or PRI_MIN - 1 if it has none. */
+static int
+hold_priority(const struct hold *hold)
 {
-	const struct thread *a = list_entry(a_, struct thread, elem);
-	const struct thread *b = list_entry(b_, struct thread, elem);
-	return (a->wakeup_tick < b->wakeup_tick);
+	int priority = PRI_MIN - 1;
+
+	for (int i = 0; i < 2 && hold->waiters[i] != NULL; i++)
+	{
+		struct pqueue_elem *e = pq_top(hold->waiters[i]);
+		if (e != NULL && e->key > priority)
+			priority = e->key;
+	}
+	return priority;
 }
 
-// 우선순위가 높은것이 먼저와야 하기 때문에.
-bool cmp_priority(struct list_elem *a_, struct list_elem *b_, void *aux UNUSED)
+/* Orders holds in a thread's held_locks heap by the priority
+   that they donate. */
+static bool
+held_lock_less(const struct pheap_elem *a_, const struct pheap_elem *b_,
+			   void *aux UNUSED)
 {
-	const struct thread *a = list_entry(a_, struct thread, elem);
-	const struct thread *b = list_entry(b_, struct thread, elem);
-	return (a->priority > b->priority);
+	const struct hold *a = pheap_entry(a_, struct hold, elem);
+	const struct hold *b = pheap_entry(b_, struct hold, elem);
+	return hold_priority(a) < hold_priority(b);
 }
 
-bool cmp_dpriority(struct list_elem *a_, struct list_elem *b_, void *aux UNUSED)
+/* Returns T's effective priority: its own priority, or the
+   highest priority donated through a lock it holds, whichever
+   is greater.  O(1), since held_locks is a max-heap. */
+static int
+effective_priority(struct thread *t)
 {
-	const struct thread *a = list_entry(a_, struct thread, d_elem);
-	const struct thread *b = list_entry(b_, struct thread, d_elem);
-	return (a->priority > b->priority);
+	struct pheap_elem *e = pheap_top(&t->held_locks);
+	int donated = e != NULL ? hold_priority(pheap_entry(e, struct hold, elem))
+							: PRI_MIN - 1;
+	return donated > t->init_priority ? donated : t->init_priority;
 }
 
-// 현재 수행중인 스레드와 가장 높은 우선순위의 스레드를 우선비교하여 스케줄링
-void test_max_priority(void)
+/* HOLD, which HOLDER holds, may donate more than before: puts it
+   back in order among HOLDER's holds and raises HOLDER's
+   priority.  If it rises, passes the donation on to whatever
+   HOLDER is itself waiting for.  Past DONATE_DEPTH_MAX links
+   HOLD is still put back in order, since the previous link
+   re-keyed its waiters, but HOLDER's priority is left alone. */
+static void
+donate(struct thread *holder, struct hold *hold, tid_t donor, int depth)
 {
-	struct thread *curr = thread_current();
-	// 우선순위는 매번 변하기 때문에 넣거나 뺄때 sort를 해야함.
-	// list_sort(&ready_list, cmp_priority, NULL);
-	if (curr->priority < list_entry(list_begin(&ready_list), struct thread, elem)->priority)
-	{
-		thread_yield();
-	}
+	int priority;
+
+	pheap_update(&holder->held_locks, &hold->elem);
+	if (depth >= DONATE_DEPTH_MAX)
+		return;
+	priority = effective_priority(holder);
+	if (priority <= holder->priority)
+		return;
+	/* This also re-keys HOLDER in the queue it waits in. */
+	thread_update_priority(holder, priority);
+	trace_event(TRACE_DONATE, holder, donor);
+	donate_to_holders(holder, donor, depth + 1);
+}
+
+/* Donates T's priority to the holders of the lock or
+   reader-writer lock that T is waiting for, if any: to every
+   reader of a read-held rwlock, not just one.  Gives up after
+   DONATE_DEPTH_MAX links. */
+static void
+donate_to_holders(struct thread *t, tid_t donor, int depth)
+{
+	struct list_elem *e;
+
+	/* A lock between release and its next acquire has no holder
+	   to pass the donation on to; whoever acquires it next picks
+	   it up from the lock's waiters. */
+	if (t->wait_on_lock != NULL && t->wait_on_lock->holder != NULL)
+		donate(t->wait_on_lock->holder, &t->wait_on_lock->hold, donor, depth);
+	else if (t->wait_on_rw != NULL)
+		for (e = list_begin(&t->wait_on_rw->holders);
+			 e != list_end(&t->wait_on_rw->holders); e = list_next(e))
+		{
+			struct rw_hold *h = list_entry(e, struct rw_hold, elem);
+			donate(h->thread, &h->hold, donor, depth);
+		}
 }
 
 // 내가 가지려고 하는 락을 가진 스레드에게 도네이션을 한다.
+/* Called by lock_acquire() after queuing the current thread on
+   LOCK, which is held by another thread.  Donates the current
+   thread's priority along the chain of lock holders: to LOCK's
+   holder, to the holder of the lock that thread is waiting on,
+   and so on, for at most DONATE_DEPTH_MAX links.  Each link
+   re-keys a held lock and a waiting holder in O(log n), and the
+   walk stops as soon as a holder's priority does not rise.
+   Interrupts must be off. */
 void priority_donate(struct lock *lock)
 {
-	// if(lock->holder->priority < thread_current()->priority){
+	struct thread *curr = thread_current();
 
-	// struct lock *temp = lock;
-	// struct thread *temp_t = thread_current();
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(lock->holder != NULL);
+
+	curr->wait_on_lock = lock;
+	donate_to_holders(curr, curr->tid, 0);
+}
 
-	// while(temp !=NULL){
-	// 	if(list_empty(&temp->holder->donators)){
-	// 		list_push_back(&temp->holder->donators, &temp_t->d_elem); //donators 리스트에 현재 리스트 추가
-	// 		temp->holder->priority = temp_t->priority;
-	// 	}
-	// }
-	// 현재 쓰레드가 기다리고 있는 lock과 연결된 모든 쓰레드들을 순회하며
-	//  현재 쓰레드의 우선순위를 Lock을 보유하고있는 쓰레드에게 기부
+/* Like priority_donate(), for a thread that rw_read_acquire()
+   or rw_write_acquire() has queued on RW.  Every current holder
+   of RW receives the donation.  Interrupts must be off. */
+void priority_donate_rw(struct rwlock *rw)
+{
 	struct thread *curr = thread_current();
-	for (int depth = 0; depth < 8; depth++)
-	{
-		if (!curr->wait_on_lock)
-		{
-			break;
-		}
 
-		struct thread *holder = curr->wait_on_lock->holder;
-		holder->priority = list_entry(list_max(&holder->donators, cmp_dpriority, NULL), struct thread, d_elem)->priority;
-		holder->priority = curr->priority;
+	ASSERT(intr_get_level() == INTR_OFF);
 
-		if (list_empty(&holder->donators))
-		{
-			// holder->priority = curr->priority;
-			curr->priority = curr->init_priority;
-		}
-		curr = holder;
-	}
+	curr->wait_on_rw = rw;
+	donate_to_holders(curr, curr->tid, 0);
 }
 
-/* 현재 스레드의 donators 리스트에서 특정 락을 대기하고 있던 모든 스레드를 제거함. */
-// 이 락을 대기하던 스레드들이 실행 가능 상태로 전환되어야 하므로,
-// 현재 스레드의 donators 에서 제거하는 작업
-void remove_with_lock(struct lock *lock)
+/* Records that the current thread has acquired HOLD, a lock or
+   a hold on a reader-writer lock: it stops waiting, if it was,
+   and starts receiving the priority of HOLD's remaining
+   waiters.  Interrupts must be off. */
+void priority_hold_acquired(struct hold *hold)
 {
-	// lock을 해지했을때 waiters list에서 해당 엔트리를 삭제하기 위함.
 	struct thread *curr = thread_current();
-	struct list_elem *temp;
 
-	for (temp = list_begin(&lock->holder->donators); temp != list_end(&lock->holder->donators); temp = list_next(temp))
-	{
-		struct thread *d_t = list_entry(temp, struct thread, d_elem);
-		if (d_t->wait_on_lock == lock)
-		{
-			// 특정 락이 해제 되었을때, 그 락떄문에 기다리던 모든 스레드들이 자신의
-			// 우선순위 기부자리스트(donators)에서 제거되도록 하는데 사용
-			list_remove(&d_t->d_elem);
-		}
-	}
-	if (list_empty(&lock->holder->donators))
-	{
-		curr->priority = curr->init_priority;
-	}
-	else
-	{
-		curr->priority = list_entry(list_max(&lock->holder->donators, cmp_dpriority, NULL), struct thread, d_elem)->priority;
-	}
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	curr->wait_on_lock = NULL;
+	curr->wait_on_rw = NULL;
+	pheap_insert(&curr->held_locks, &hold->elem);
+	refresh_priority();
+}
+
+/* Records that the current thread has released HOLD, dropping
+   whatever priority HOLD's waiters donated.  Interrupts must be
+   off. */
+void priority_hold_released(struct hold *hold)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	pheap_remove(&thread_current()->held_locks, &hold->elem);
+	refresh_priority();
 }
-void refresh_priority(struct lock *lock)
+
+/* Recomputes the current thread's effective priority after its
+   own priority or the set of locks it holds has changed.  The
+   running thread waits on no lock, so nothing needs to be passed
+   on. */
+void refresh_priority(void)
 {
-	// 스레드의 우선순위가 변경되었을때 donation을 고려하여 우선순위를 다시 결정
-	// 현제스레드의 우선순위를 기부 받기 전의 우선순위로 변경
 	struct thread *curr = thread_current();
-	curr->priority = curr->init_priority;
-	if (!list_empty(&lock->holder->donators))
-	{
-		list_sort(&lock->holder->donators, cmp_dpriority, NULL);
-		struct thread *tmp = list_entry(list_max(&lock->holder->donators, cmp_dpriority, NULL), struct thread, d_elem);
-		if (curr->priority < tmp->priority)
-		{
-			curr->priority = tmp->priority;
-		}
-	}
-}
\ No newline at end of file
+	thread_update_priority(curr, effective_priority(curr));
+}
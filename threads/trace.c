@@ -0,0 +1,97 @@
+#include "threads/trace.h"
+#ifdef SCHED_TRACE
+#include <debug.h>
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Events recorded by trace_print_cost(). */
+#define TRACE_COST_CNT TRACE_SIZE
+
+/* Gives each online CPU its ring buffer.  Events that happen
+   before this, during early boot, are not recorded. */
+void
+trace_init (void) {
+	size_t page_cnt = DIV_ROUND_UP (sizeof (struct trace_buf), PGSIZE);
+
+	for (int i = 0; i < cpu_cnt; i++)
+		cpus[i].trace = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, page_cnt);
+}
+
+/* Stops tracing and prints every CPU's buffered records to the
+   console, oldest first, as one line of hex per record between
+   "TRACE BEGIN" and "TRACE END" lines.  The bytes of each record
+   are printed in memory order, so utils/trace2json can unpack
+   them as a little-endian struct trace_record. */
+void
+trace_dump (void) {
+	struct trace_buf *bufs[CPU_MAX];
+	enum intr_level old_level;
+
+	/* Detach the buffers first, so that printing does not record
+	   events into the buffer being printed. */
+	old_level = intr_disable ();
+	for (int i = 0; i < cpu_cnt; i++) {
+		bufs[i] = cpus[i].trace;
+		cpus[i].trace = NULL;
+	}
+	intr_set_level (old_level);
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		struct trace_buf *b = bufs[i];
+		uint64_t first, seq;
+
+		if (b == NULL)
+			continue;
+		first = b->head > TRACE_SIZE ? b->head - TRACE_SIZE : 0;
+		printf ("TRACE BEGIN cpu=%d hz=%"PRIu64" count=%"PRIu64
+				" lost=%"PRIu64"\n", i, timer_tsc_hz (), b->head - first, first);
+		for (seq = first; seq < b->head; seq++) {
+			const uint8_t *p = (const uint8_t *) &b->rec[seq & (TRACE_SIZE - 1)];
+			char line[sizeof (struct trace_record) * 2 + 1];
+
+			for (size_t j = 0; j < sizeof (struct trace_record); j++)
+				snprintf (line + 2 * j, 3, "%02x", p[j]);
+			printf ("%s\n", line);
+		}
+		printf ("TRACE END\n");
+	}
+}
+
+/* Measures how long trace_event() takes, by recording
+   TRACE_COST_CNT events with interrupts off into a scratch buffer
+   that stands in for this CPU's, and prints the average in TSC
+   cycles and nanoseconds against TRACE_BUDGET_NS. */
+void
+trace_print_cost (void) {
+	size_t page_cnt = DIV_ROUND_UP (sizeof (struct trace_buf), PGSIZE);
+	struct trace_buf *scratch = palloc_get_multiple (PAL_ZERO, page_cnt);
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	struct trace_buf *saved;
+	uint64_t start, cycles, ns;
+
+	if (scratch == NULL)
+		return;
+
+	old_level = intr_disable ();
+	saved = cpu_current ()->trace;
+	cpu_current ()->trace = scratch;
+	start = rdtsc ();
+	for (int i = 0; i < TRACE_COST_CNT; i++)
+		trace_event (TRACE_TICK, curr, i);
+	cycles = (rdtsc () - start) / TRACE_COST_CNT;
+	cpu_current ()->trace = saved;
+	intr_set_level (old_level);
+	palloc_free_multiple (scratch, page_cnt);
+
+	ns = timer_tsc_hz () ? cycles * 1000000000 / timer_tsc_hz () : 0;
+	printf ("Trace: %"PRIu64" cycles (%"PRIu64" ns) per event, "
+			"%s the %d ns budget\n", cycles, ns,
+			ns <= TRACE_BUDGET_NS ? "within" : "over", TRACE_BUDGET_NS);
+}
+#endif /* SCHED_TRACE */
@@ -0,0 +1,166 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* A worker thread and its queue of pending work. */
+struct worker {
+	struct list queue;          /* Queued struct works, oldest first. */
+	struct semaphore ready;     /* Upped once for each queued work. */
+};
+
+static struct worker workers[WORK_PRI_CNT];
+static bool workers_started;
+
+/* The MLFQS and CFS schedulers ignore the priority passed to
+   thread_create(), so each worker also has a niceness. */
+static const struct {
+	const char *name;
+	int priority;
+	int nice;
+} worker_info[WORK_PRI_CNT] = {
+	[WORK_HIGH] = { "kworker/high", PRI_MAX - 1, NICE_DEFAULT },
+	[WORK_NORMAL] = { "kworker/normal", PRI_DEFAULT, NICE_DEFAULT },
+	[WORK_LOW] = { "kworker/low", PRI_MIN, NICE_MAX },
+};
+
+static thread_func worker_loop;
+static timer_func work_timer_fire;
+static void work_enqueue (struct work *);
+
+/* Starts one worker thread per work priority.  Must be called
+   after thread_start(). */
+void
+workqueue_init (void) {
+	for (int i = 0; i < WORK_PRI_CNT; i++) {
+		list_init (&workers[i].queue);
+		sema_init (&workers[i].ready, 0);
+		if (thread_create (worker_info[i].name, worker_info[i].priority,
+					worker_loop, &workers[i]) == TID_ERROR)
+			PANIC ("could not start %s", worker_info[i].name);
+	}
+	workers_started = true;
+}
+
+/* Initializes W to call FUNC with AUX in the worker thread for
+   PRIORITY. */
+void
+work_init (struct work *w, work_func *func, void *aux,
+		enum work_priority priority) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+	ASSERT (priority < WORK_PRI_CNT);
+
+	w->func = func;
+	w->aux = aux;
+	w->priority = priority;
+	w->pending = false;
+	w->timer.pending = false;
+}
+
+/* Queues W to run in its worker thread.  Returns false, without
+   doing anything, if W is already pending.  May be called from
+   an interrupt handler. */
+bool
+queue_work (struct work *w) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (workers_started);
+
+	old_level = intr_disable ();
+	if (!w->pending) {
+		w->pending = true;
+		work_enqueue (w);
+		queued = true;
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Queues W to run in its worker thread once TICKS timer ticks
+   have passed.  Returns false, without doing anything, if W is
+   already pending.  May be called from an interrupt handler. */
+bool
+queue_delayed_work (struct work *w, int64_t ticks) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	if (ticks <= 0)
+		return queue_work (w);
+
+	ASSERT (workers_started);
+
+	old_level = intr_disable ();
+	if (!w->pending) {
+		w->pending = true;
+		timer_add (&w->timer, timer_ticks () + ticks, work_timer_fire, w);
+		queued = true;
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Takes W off its worker's queue, or stops its delay, if it is
+   pending.  Returns true if it was pending, false if it was
+   idle or its function has already started. */
+bool
+cancel_work (struct work *w) {
+	enum intr_level old_level = intr_disable ();
+	bool was_pending = w->pending;
+
+	if (was_pending) {
+		if (!timer_cancel (&w->timer))
+			list_remove (&w->elem);
+		w->pending = false;
+	}
+	intr_set_level (old_level);
+	return was_pending;
+}
+
+/* Timer function for queue_delayed_work(): W's delay is over. */
+static void
+work_timer_fire (void *w) {
+	work_enqueue (w);
+}
+
+/* Appends pending work W to its worker's queue and wakes the
+   worker.  Interrupts must be off. */
+static void
+work_enqueue (struct work *w) {
+	struct worker *worker = &workers[w->priority];
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	list_push_back (&worker->queue, &w->elem);
+	sema_up (&worker->ready);
+}
+
+/* Body of a worker thread: runs the work on WORKER_'s queue, in
+   order, forever. */
+static void
+worker_loop (void *worker_) {
+	struct worker *worker = worker_;
+
+	if (thread_mlfqs || thread_cfs)
+		thread_set_nice (worker_info[worker - workers].nice);
+
+	for (;;) {
+		struct work *w = NULL;
+		enum intr_level old_level;
+
+		sema_down (&worker->ready);
+
+		/* Cancelled work leaves the semaphore ahead of the queue. */
+		old_level = intr_disable ();
+		if (!list_empty (&worker->queue)) {
+			w = list_entry (list_pop_front (&worker->queue), struct work, elem);
+			w->pending = false;
+		}
+		intr_set_level (old_level);
+
+		if (w != NULL)
+			w->func (w->aux);
+	}
+}
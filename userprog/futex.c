@@ -0,0 +1,188 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+
+/* Fast user-space mutexes.
+
+   A user program keeps its lock state in an ordinary int and
+   only calls into the kernel when it has to sleep or wake a
+   sleeper.  The kernel keeps no state for an int that nobody
+   sleeps on: sleeping threads queue in a hash table of buckets,
+   keyed by their address space and the user virtual address of
+   the int, so two processes that use the same address do not
+   wake each other.
+
+   futex_wait() checks the int and queues the caller with
+   interrupts off, and futex_wake() dequeues with interrupts off,
+   so a wakeup cannot slip in between the check and the sleep. */
+
+#define FUTEX_BUCKETS 64
+
+/* A thread sleeping in futex_wait().  Lives on its stack. */
+struct futex_waiter {
+	struct list_elem elem;      /* Element in a bucket's list. */
+	uint64_t *pml4;             /* Address space of UADDR. */
+	int *uaddr;                 /* User address slept on. */
+	struct thread *thread;      /* The sleeping thread. */
+	struct timer_event timer;   /* Fires at the timeout, if any. */
+	int result;                 /* FUTEX_WOKEN or FUTEX_TIMEDOUT. */
+};
+
+/* Waiters whose keys hash to the same bucket, oldest first. */
+static struct list buckets[FUTEX_BUCKETS];
+
+static timer_func futex_timeout;
+
+/* Initializes the futex hash table. */
+void
+futex_init (void) {
+	int i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++)
+		list_init (&buckets[i]);
+}
+
+/* Returns the bucket for UADDR in address space PML4. */
+static struct list *
+futex_bucket (uint64_t *pml4, int *uaddr) {
+	uintptr_t key[2] = { (uintptr_t) pml4, (uintptr_t) uaddr };
+
+	return &buckets[hash_bytes (key, sizeof key) % FUTEX_BUCKETS];
+}
+
+/* Returns the kernel address of the int at UADDR in the current
+   address space, or a null pointer if UADDR is misaligned or not
+   mapped.
+
+   Only pages already present in the page table count as mapped.
+   With VM, a lazily loaded page that the program has not touched
+   yet gets FUTEX_FAULT although it is valid.  Faulting it in here
+   needs vm_claim_page(), which is still a stub that cannot fail
+   gracefully, so user programs must touch a futex word first;
+   initializing it, as every lock does, is enough. */
+static int *
+futex_kaddr (int *uaddr) {
+	if (uaddr == NULL || !is_user_vaddr (uaddr)
+			|| (uintptr_t) uaddr % sizeof *uaddr != 0)
+		return NULL;
+	return pml4_get_page (thread_current ()->pml4, uaddr);
+}
+
+/* If the int at UADDR still holds EXPECTED, sleeps until
+   futex_wake() is called on UADDR or, if TIMEOUT is not negative,
+   until TIMEOUT timer ticks have passed.  Returns FUTEX_WOKEN,
+   FUTEX_TIMEDOUT, FUTEX_AGAIN if the int did not hold EXPECTED,
+   or FUTEX_FAULT if UADDR is bad.  Returns FUTEX_WOKEN without
+   sleeping if the process is exiting: futex_wake_all() may
+   already have run, and the caller must get back to user mode
+   to exit. */
+int
+futex_wait (int *uaddr, int expected, int64_t timeout) {
+	struct thread *curr = thread_current ();
+	struct futex_waiter w;
+	enum intr_level old_level;
+	int *kaddr = futex_kaddr (uaddr);
+
+	if (kaddr == NULL)
+		return FUTEX_FAULT;
+
+	old_level = intr_disable ();
+	if (process_leader (curr)->exiting) {
+		intr_set_level (old_level);
+		return FUTEX_WOKEN;
+	}
+	if (*kaddr != expected || timeout == 0) {
+		intr_set_level (old_level);
+		return *kaddr != expected ? FUTEX_AGAIN : FUTEX_TIMEDOUT;
+	}
+
+	w.pml4 = curr->pml4;
+	w.uaddr = uaddr;
+	w.thread = curr;
+	w.result = FUTEX_WOKEN;
+	w.timer.pending = false;
+	list_push_back (futex_bucket (w.pml4, uaddr), &w.elem);
+	if (timeout >= 0)
+		timer_add (&w.timer, timer_ticks () + timeout, futex_timeout, &w);
+	thread_block ();
+	intr_set_level (old_level);
+
+	return w.result;
+}
+
+/* Wakes up to N threads sleeping on UADDR, oldest first.
+   Returns the number woken, or FUTEX_FAULT if UADDR is bad. */
+int
+futex_wake (int *uaddr, int n) {
+	uint64_t *pml4 = thread_current ()->pml4;
+	struct list *bucket;
+	struct list_elem *e;
+	enum intr_level old_level;
+	int woken = 0;
+
+	if (futex_kaddr (uaddr) == NULL)
+		return FUTEX_FAULT;
+
+	old_level = intr_disable ();
+	bucket = futex_bucket (pml4, uaddr);
+	for (e = list_begin (bucket); e != list_end (bucket) && woken < n; ) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		e = list_next (e);
+		if (w->pml4 != pml4 || w->uaddr != uaddr)
+			continue;
+		list_remove (&w->elem);
+		timer_cancel (&w->timer);
+		thread_unblock (w->thread);
+		woken++;
+	}
+	intr_set_level (old_level);
+
+	if (woken > 0)
+		test_max_priority ();
+	return woken;
+}
+
+/* Wakes every thread sleeping on any address in the address
+   space PML4, for a process that is exiting. */
+void
+futex_wake_all (uint64_t *pml4) {
+	enum intr_level old_level = intr_disable ();
+	int i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		struct list_elem *e;
+
+		for (e = list_begin (&buckets[i]); e != list_end (&buckets[i]); ) {
+			struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+			e = list_next (e);
+			if (w->pml4 != pml4)
+				continue;
+			list_remove (&w->elem);
+			timer_cancel (&w->timer);
+			thread_unblock (w->thread);
+		}
+	}
+	intr_set_level (old_level);
+}
+
+/* Timer callback that wakes waiter W_ when its timeout expires.
+   A waiter that futex_wake() already dequeued has cancelled its
+   timer, so W_ is still queued here. */
+static void
+futex_timeout (void *w_) {
+	struct futex_waiter *w = w_;
+
+	list_remove (&w->elem);
+	w->result = FUTEX_TIMEDOUT;
+	thread_unblock (w->thread);
+	test_max_priority ();
+}
@@ -106,8 +106,8 @@ gdt_init (void) {
 	};
 
 	lgdt (&gdt_ds);
-	/* reload segment registers */
-	asm volatile("movw %%ax, %%gs" :: "a" (SEL_UDSEG));
+	/* reload segment registers.  %gs is left alone, since loading
+	 * it would clear the GS base that points to the per-CPU data. */
 	asm volatile("movw %%ax, %%fs" :: "a" (0));
 	asm volatile("movw %%ax, %%es" :: "a" (SEL_KDSEG));
 	asm volatile("movw %%ax, %%ds" :: "a" (SEL_KDSEG));
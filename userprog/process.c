@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
@@ -13,6 +14,7 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -26,6 +28,8 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void user_thread_start (void *);
+static void reap_user_threads (struct thread *leader);
 
 /* General process initializer for initd and other process. */
 static void
@@ -216,6 +220,26 @@ process_exit (void) {
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
+	/* A user thread leaves the address space to its leader and
+	   only reports its exit.  The leader takes every other user
+	   thread with it before tearing the address space down. */
+	if (curr->user_thread != NULL) {
+		struct user_thread *ut = curr->user_thread;
+		struct thread *leader = curr->leader;
+
+		curr->user_thread = NULL;
+		curr->pml4 = NULL;
+		pml4_activate (NULL);
+		lock_acquire (&leader->user_threads_lock);
+		ut->done = true;
+		sema_up (&ut->exited);
+		cond_broadcast (&leader->user_threads_done, &leader->user_threads_lock);
+		lock_release (&leader->user_threads_lock);
+		return;
+	}
+	if (curr->pml4 != NULL)
+		reap_user_threads (curr);
+
 	process_cleanup ();
 }
 
@@ -224,6 +248,7 @@ static void
 process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
+	ASSERT (list_empty (&curr->user_threads));
 #ifdef VM
 	supplemental_page_table_kill (&curr->spt);
 #endif
@@ -246,6 +271,192 @@ process_cleanup (void) {
 	}
 }
 
+/* Returns the thread that owns T's address space: T's leader if
+   T is a user thread created by process_thread_create(), else T
+   itself.  The page tables and the supplemental page table of a
+   process live in its leader. */
+struct thread *
+process_leader (struct thread *t) {
+	return t->leader != NULL ? t->leader : t;
+}
+
+/* Arguments for user_thread_start(). */
+struct user_thread_args {
+	struct thread *leader;      /* Owner of the address space. */
+	struct user_thread *ut;     /* The new thread's record. */
+	void *entry;                /* User code to start at. */
+	void *arg;                  /* Passed to ENTRY in %rdi. */
+	void *stack;                /* Initial user stack pointer. */
+};
+
+/* Starts a new user thread in the current process's address
+   space, running ENTRY with ARG as its first argument on the
+   user stack that ends at STACK.  The thread has the caller's
+   priority.  Returns the new thread's tid, or TID_ERROR if it
+   could not be created or if the process is exiting. */
+tid_t
+process_thread_create (void *entry, void *arg, void *stack) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = process_leader (curr);
+	struct user_thread_args *args;
+	struct user_thread *ut;
+	tid_t tid = TID_ERROR;
+
+	if (!is_user_vaddr (entry) || !is_user_vaddr (stack))
+		return TID_ERROR;
+
+	args = malloc (sizeof *args);
+	ut = malloc (sizeof *ut);
+	if (args == NULL || ut == NULL)
+		goto done;
+	args->leader = leader;
+	args->ut = ut;
+	args->entry = entry;
+	args->arg = arg;
+	args->stack = stack;
+	sema_init (&ut->exited, 0);
+	ut->joining = false;
+	ut->done = false;
+
+	/* Hold the lock across thread_create(), so that the record is
+	   listed before the thread can run, exit, or be joined. */
+	lock_acquire (&leader->user_threads_lock);
+	if (!leader->exiting) {
+		tid = thread_create (curr->name, thread_get_priority (),
+				user_thread_start, args);
+		if (tid != TID_ERROR) {
+			ut->tid = tid;
+			list_push_back (&leader->user_threads, &ut->elem);
+		}
+	}
+	lock_release (&leader->user_threads_lock);
+
+done:
+	if (tid == TID_ERROR) {
+		free (args);
+		free (ut);
+	}
+	return tid;
+}
+
+/* A thread function that enters user mode in the address space
+   of ARGS_->leader. */
+static void
+user_thread_start (void *args_) {
+	struct user_thread_args *args = args_;
+	struct thread *curr = thread_current ();
+	struct intr_frame if_;
+
+	curr->leader = args->leader;
+	curr->user_thread = args->ut;
+	curr->pml4 = args->leader->pml4;
+	process_activate (curr);
+
+	memset (&if_, 0, sizeof if_);
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+	if_.rip = (uintptr_t) args->entry;
+	if_.rsp = (uintptr_t) args->stack;
+	if_.R.rdi = (uintptr_t) args->arg;
+	free (args);
+
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* Waits for user thread TID of the current process to exit.
+   Returns 0 once it has, or -1 without waiting if TID is not a
+   user thread of this process, is the caller, or has already
+   been joined.  Also returns -1, at once or as soon as it
+   happens, if the process is exiting; the leader then frees the
+   record. */
+int
+process_thread_join (tid_t tid) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = process_leader (curr);
+	struct user_thread *ut = NULL;
+	struct list_elem *e;
+
+	lock_acquire (&leader->user_threads_lock);
+	for (e = list_begin (&leader->user_threads);
+			e != list_end (&leader->user_threads) && !leader->exiting;
+			e = list_next (e)) {
+		struct user_thread *u = list_entry (e, struct user_thread, elem);
+		if (u->tid == tid && !u->joining && u != curr->user_thread) {
+			ut = u;
+			ut->joining = true;
+			break;
+		}
+	}
+	lock_release (&leader->user_threads_lock);
+	if (ut == NULL)
+		return -1;
+
+	/* reap_user_threads() ups `exited' to wake us if the process
+	   starts exiting; UT is then no longer ours to touch. */
+	sema_down (&ut->exited);
+	lock_acquire (&leader->user_threads_lock);
+	if (leader->exiting) {
+		lock_release (&leader->user_threads_lock);
+		return -1;
+	}
+	list_remove (&ut->elem);
+	lock_release (&leader->user_threads_lock);
+	free (ut);
+	return 0;
+}
+
+/* Makes every user thread of LEADER's process exit, waits for
+   them, and frees their records.  Threads in user mode exit at
+   their next interrupt, threads in the kernel on their way back
+   to user mode.  Futex sleepers and joiners are woken so that
+   they get there; joiners may be waiting on each other, so none
+   of them is left to finish its join. */
+static void
+reap_user_threads (struct thread *leader) {
+	struct list_elem *e;
+
+	lock_acquire (&leader->user_threads_lock);
+	leader->exiting = true;
+	for (e = list_begin (&leader->user_threads);
+			e != list_end (&leader->user_threads); e = list_next (e)) {
+		struct user_thread *ut = list_entry (e, struct user_thread, elem);
+		if (ut->joining && !ut->done)
+			sema_up (&ut->exited);
+	}
+	lock_release (&leader->user_threads_lock);
+
+	futex_wake_all (leader->pml4);
+
+	lock_acquire (&leader->user_threads_lock);
+	for (;;) {
+		bool running = false;
+
+		for (e = list_begin (&leader->user_threads);
+				e != list_end (&leader->user_threads); e = list_next (e))
+			if (!list_entry (e, struct user_thread, elem)->done)
+				running = true;
+		if (!running)
+			break;
+		cond_wait (&leader->user_threads_done, &leader->user_threads_lock);
+	}
+	while (!list_empty (&leader->user_threads))
+		free (list_entry (list_pop_front (&leader->user_threads),
+				struct user_thread, elem));
+	lock_release (&leader->user_threads_lock);
+}
+
+/* Exits the current thread if it is a user thread whose process
+   is exiting.  Called on the way back to user mode. */
+void
+process_exit_if_killed (void) {
+	struct thread *curr = thread_current ();
+
+	if (curr->leader != NULL && curr->leader->exiting)
+		thread_exit ();
+}
+
 /* Sets up the CPU for running user code in the nest thread.
  * This function is called on every context switch. */
 void
@@ -4,7 +4,9 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
+#include "userprog/process.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
 
@@ -35,12 +37,40 @@ syscall_init (void) {
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
+
+	futex_init ();
 }
 
 /* The main system call interface */
 void
-syscall_handler (struct intr_frame *f UNUSED) {
-	// TODO: Your implementation goes here.
-	printf ("system call!\n");
-	thread_exit ();
+syscall_handler (struct intr_frame *f) {
+	switch (f->R.rax) {
+		case SYS_SET_DEADLINE:
+			f->R.rax = thread_set_deadline (f->R.rdi, f->R.rsi);
+			break;
+		case SYS_FUTEX_WAIT:
+			f->R.rax = futex_wait ((int *) f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_FUTEX_WAKE:
+			f->R.rax = futex_wake ((int *) f->R.rdi, f->R.rsi);
+			break;
+		case SYS_THREAD_CREATE:
+			f->R.rax = process_thread_create ((void *) f->R.rdi,
+					(void *) f->R.rsi, (void *) f->R.rdx);
+			break;
+		case SYS_THREAD_JOIN:
+			f->R.rax = process_thread_join (f->R.rdi);
+			break;
+		case SYS_THREAD_EXIT:
+			thread_exit ();
+			NOT_REACHED ();
+		default:
+			// TODO: Your implementation goes here.
+			printf ("system call!\n");
+			thread_exit ();
+	}
+
+	/* The process may have started exiting while we were in the
+	   kernel. */
+	process_exit_if_killed ();
 }